@@ -1,5 +1,25 @@
+#ifndef CONCEPTS_HPP
+#define CONCEPTS_HPP
+
 template <typename T>
 concept LockConcept = requires (T t) {
     { t.lock() };
     { t.unlock() };
 };
+
+template <typename T>
+concept SharedLockConcept = LockConcept<T> && requires (T t) {
+    { t.lock_shared() };
+    { t.unlock_shared() };
+};
+
+/* Runs critical sections on the caller's behalf: apply(f) calls f(state)
+ * with exclusive access to the protected State and returns f's result.
+ * Whether f runs on the calling thread (under a lock) or on some other
+ * thread (combining, delegation) is up to T. */
+template <typename T, typename State>
+concept ExecutorConcept = requires (T t) {
+    { t.apply([](State&) {}) };
+};
+
+#endif
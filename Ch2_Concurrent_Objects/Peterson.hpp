@@ -1,3 +1,7 @@
+#ifndef PETERSON_HPP
+#define PETERSON_HPP
+
+#include <atomic>
 #include <thread>
 #include <iostream>
 #include "Concepts.hpp"
@@ -13,7 +17,9 @@ public:
                                                 currThreadID,
                                                 std::memory_order_seq_cst,
                                                 std::memory_order_seq_cst)) {
+            #ifdef ENABLE_LOGGING
             std::cout << "FIRST THREAD: " << firstThread << std::endl;
+            #endif
         }
 
         int thisID = currThreadID == firstThread.load();
@@ -46,7 +52,9 @@ public:
                                                 currThreadID,
                                                 std::memory_order_seq_cst,
                                                 std::memory_order_seq_cst)) {
+            #ifdef ENABLE_LOGGING
             std::cout << "FIRST THREAD: " << firstThread << std::endl;
+            #endif
         }
 
         int thisID = currThreadID == firstThread.load();
@@ -67,3 +75,5 @@ private:
     std::atomic<std::thread::id> firstThread;
 };
 static_assert(LockConcept<PetersonGood>);
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef THREAD_INDEX_HPP
+#define THREAD_INDEX_HPP
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/* Dense per-thread index: 0, 1, 2, ... for the live threads of the process.
+ * A thread gets its index the first time it asks and keeps it (cached in a
+ * thread_local) until it exits, when the index is handed back for reuse. So
+ * with at most N live threads every index is < N, even if threads come and
+ * go. Only the first call on a thread and thread exit take the mutex. */
+class ThreadIndex {
+public:
+    static unsigned get() {
+        thread_local const Slot slot;
+        return slot.index;
+    }
+
+    /* get() for structures with a fixed table of 'limit' per-thread records;
+     * throws std::runtime_error, naming 'owner', past the end of the table */
+    static unsigned getBelow(unsigned limit, const char* owner) {
+        unsigned index = get();
+        if (index >= limit) {
+            throw std::runtime_error(std::string(owner) + ": more live threads than MAX_THREADS");
+        }
+        return index;
+    }
+
+    /* Raises highWater to index + 1 unless it is already past index. For
+     * structures whose scans only visit records below highWater: call it
+     * before the record at 'index' is first used. 'order' is that of the
+     * raise itself; hazard pointer and epoch scans need seq_cst. */
+    static void raiseHighWater(std::atomic<unsigned>& highWater, unsigned index,
+                               std::memory_order order = std::memory_order_release) {
+        unsigned current = highWater.load(std::memory_order_relaxed);
+        while (current <= index &&
+               !highWater.compare_exchange_weak(current, index + 1, order,
+                                                std::memory_order_relaxed)) {}
+    }
+
+private:
+    struct Slot {
+        Slot() {
+            std::lock_guard<std::mutex> guard{registryMutex()};
+            std::vector<unsigned>& freeList = freeIndices();
+            if (freeList.empty()) {
+                index = nextIndex()++;
+            } else {
+                index = freeList.back();
+                freeList.pop_back();
+            }
+        }
+
+        ~Slot() {
+            std::lock_guard<std::mutex> guard{registryMutex()};
+            freeIndices().push_back(index);
+        }
+
+        unsigned index;
+    };
+
+    static std::mutex& registryMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static std::vector<unsigned>& freeIndices() {
+        static std::vector<unsigned> indices;
+        return indices;
+    }
+
+    static unsigned& nextIndex() {
+        static unsigned next = 0;
+        return next;
+    }
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef TOURNAMENT_LOCK_HPP
+#define TOURNAMENT_LOCK_HPP
+
+#include <algorithm>  // max
+#include <atomic>
+#include <bit>        // bit_ceil
+#include <cstddef>
+#include <memory>     // unique_ptr
+#include <new>        // hardware_destructive_interference_size
+#include <stdexcept>
+#include "Concepts.hpp"
+#include "ThreadIndex.hpp"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+
+/* N-thread starvation-free lock built from 2-thread Peterson locks arranged
+ * as a binary tree (a tournament). Thread i starts at leaf i and has to win
+ * the Peterson lock of every node on its way to the root; the side it plays
+ * at each node is the parity of the child it came from. Like PetersonGood
+ * it only uses loads and stores, no read-modify-write instructions.
+ *
+ * Threads are identified by ThreadIndex, so the thread::id lookup and the
+ * atomic<thread::id> handshake of PetersonGood are gone. At most
+ * 'capacity' threads may be alive while using the lock.
+ *
+ * Ordering: the lock path needs each thread's stores (interested, victim)
+ * to be ordered before its loads of the other side's fields, which
+ * acquire/release does not give (it allows store->load reordering), so
+ * those stay seq_cst. The release of a node only has to publish the
+ * critical section, so it is a release store. */
+class TournamentLock {
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 64;
+
+    explicit TournamentLock(std::size_t capacity = DEFAULT_CAPACITY)
+    : leaves{std::bit_ceil(std::max<std::size_t>(capacity, 2))},
+      nodes{std::make_unique<PetersonNode[]>(leaves)} {}
+
+    void lock() {
+        std::size_t leaf = leafOf(ThreadIndex::get());
+        // climb from the leaf's parent to the root (node 1)
+        for (std::size_t child = leaf; child > 1; child /= 2) {
+            nodes[child / 2].lock(child % 2);
+        }
+    }
+
+    void unlock() {
+        std::size_t leaf = leafOf(ThreadIndex::get());
+        // leave the root first, then the lower nodes rivals wait on: a rival
+        // let through a lower node climbs into our side of the nodes above it,
+        // which must already be given up by then
+        std::size_t levels = std::bit_width(leaves) - 1;
+        for (std::size_t level = levels; level > 0; level--) {
+            std::size_t child = leaf >> (level - 1);
+            nodes[child / 2].unlock(child % 2);
+        }
+    }
+
+private:
+    /* Peterson lock for the two sides (0, 1) of one node. Each field has
+     * its own cache line: a side writes 'interested[side]' and 'victim' and
+     * spins on the other ones. */
+    struct PetersonNode {
+        void lock(int side) {
+            interested[side].flag.store(true);
+            victim.value.store(side);
+            while (interested[1 - side].flag.load() && victim.value.load() == side) {}
+        }
+
+        void unlock(int side) {
+            interested[side].flag.store(false, std::memory_order_release);
+        }
+
+        struct alignas(std::hardware_destructive_interference_size) Flag {
+            std::atomic_bool flag{false};
+        };
+        struct alignas(std::hardware_destructive_interference_size) Victim {
+            std::atomic_int value{0};
+        };
+
+        Flag interested[2];
+        Victim victim;
+    };
+
+    std::size_t leafOf(unsigned index) const {
+        if (index >= leaves) {
+            throw std::runtime_error("TournamentLock: more threads than its capacity");
+        }
+        return leaves + index;
+    }
+
+    std::size_t leaves;
+    std::unique_ptr<PetersonNode[]> nodes;  // heap layout, nodes[1] is the root
+};
+static_assert(LockConcept<TournamentLock>);
+
+#pragma GCC diagnostic pop
+
+#endif
@@ -2,32 +2,61 @@
 #define ALOCK_HPP
 
 #include <atomic>
-
-#define MAX_NO_THREADS 8
-
+#include <bit>      // bit_ceil
+#include <cstddef>
+#include <memory>   // unique_ptr
+#include "Backoff.hpp"    // cpuRelax
+
+/* Anderson array lock. Every locker takes a ticket; ticket t spins on slot
+ * t & mask and is let in when the holder of ticket t-1 releases.
+ *
+ * The capacity is rounded up to a power of two so the slot is a mask
+ * rather than a modulo (which also keeps the slot sequence continuous when
+ * the ticket counter wraps). Each slot stores the ticket whose turn it is
+ * rather than a bool, so more concurrent lockers than slots only makes two
+ * waiters share a slot; it never lets both of them in.
+ *
+ * The slots are deliberately NOT padded; see CacheAwareALock. */
 class ALock {
 public:
-    ALock() {
-        ready[0] = true;
+    static constexpr std::size_t DEFAULT_CAPACITY = 64;
+
+    /* Handle returned by lock(), must be passed to the matching unlock() */
+    struct Slot {
+        std::size_t ticket{0};
+    };
+
+    explicit ALock(std::size_t capacity = DEFAULT_CAPACITY)
+    : mask{std::bit_ceil(capacity) - 1},
+      turn{std::make_unique<std::atomic<std::size_t>[]>(mask + 1)} {
+        for (std::size_t i = 0; i <= mask; i++) {
+            // ticket i - capacity is never drawn before ticket i is, so no slot starts open but 0
+            turn[i].store(i - (mask + 1), std::memory_order_relaxed);
+        }
+        turn[0].store(0, std::memory_order_relaxed);
     }
 
-    /* Return's the slot acquired by the caller. Caller must
-     * pass the returned 'slot' value to the corresponding unlock call. */
-    int lock() {
-        int slot = (tail++) % MAX_NO_THREADS;
-        while (!ready[slot]) {}
-        return slot;
+    Slot lock() {
+        std::size_t ticket = tail.fetch_add(1, std::memory_order_relaxed);
+        while (turn[ticket & mask].load(std::memory_order_acquire) != ticket) {
+            cpuRelax();
+        }
+        return Slot{ticket};
     }
 
-    void unlock(const int slot) {
-        ready[slot] = false;
-        ready[(slot+1) % MAX_NO_THREADS] = true;
+    void unlock(const Slot slot) {
+        std::size_t next = slot.ticket + 1;
+        turn[next & mask].store(next, std::memory_order_release);
+    }
+
+    std::size_t capacity() const {
+        return mask + 1;
     }
 
 private:
-    bool ready[MAX_NO_THREADS];
-    std::atomic_int tail{0};
+    std::size_t mask;
+    std::unique_ptr<std::atomic<std::size_t>[]> turn;
+    std::atomic<std::size_t> tail{0};
 };
 
 #endif
-
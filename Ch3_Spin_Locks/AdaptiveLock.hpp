@@ -0,0 +1,124 @@
+#ifndef ADAPTIVE_LOCK_HPP
+#define ADAPTIVE_LOCK_HPP
+
+#include <algorithm>
+#include <atomic>
+#include "Backoff.hpp"    // cpuRelax
+#include "CacheLine.hpp"
+#include "Concepts.hpp"
+#include "MCSLock.hpp"    // QNode
+
+/* Lock that runs as a TTAS lock while it is quiet and puts waiters in an
+ * MCS queue while it is contended (the layout of Linux's qspinlock).
+ *
+ * Ownership is always the single 'locked' word. In TTAS mode a thread spins
+ * on it directly; in queue mode it first waits in the MCS queue, and only
+ * the head of the queue spins on the word. So the mode only decides how
+ * threads wait, never who gets in, and it can flip at any moment without
+ * endangering mutual exclusion: threads that were already spinning TTAS
+ * style just compete with the queue head.
+ *
+ * The holder decides the mode, so the bookkeeping needs no atomics of its
+ * own: in TTAS mode each acquisition adds its failed exchanges to a score
+ * (and a clean one takes one off); past QUEUE_THRESHOLD the lock switches to
+ * queue mode. In queue mode a head that finds nobody queued behind it counts
+ * as quiet; after QUIET_THRESHOLD quiet acquisitions in a row it switches
+ * back. A TTAS waiter that keeps failing joins the queue on its own. */
+class AdaptiveLock {
+public:
+    static constexpr unsigned QUEUE_THRESHOLD = 64;
+    static constexpr unsigned QUIET_THRESHOLD = 64;
+    static constexpr unsigned MAX_FAILURES = 8;  // failed exchanges before a TTAS waiter queues
+
+    void lock() {
+        unsigned failures = 0;
+        if (!queued.load(std::memory_order_relaxed)) {
+            while (failures < MAX_FAILURES) {
+                while (locked.load(std::memory_order_relaxed)) {
+                    cpuRelax();
+                }
+                if (!locked.exchange(true, std::memory_order_acquire)) {
+                    adapt(failures, tail.load(std::memory_order_relaxed) == nullptr);
+                    return;
+                }
+                failures++;
+            }
+        }
+        lockQueued(failures);
+    }
+
+    void unlock() {
+        locked.store(false, std::memory_order_release);
+    }
+
+    /* For tests and benchmarks: how often the lock changed mode */
+    unsigned long switches() const {
+        return switchCount;
+    }
+
+private:
+    void lockQueued(unsigned failures) {
+        MCSLock::QNode node;
+        node.locked.store(true, std::memory_order_relaxed);
+        MCSLock::QNode* pred = tail.exchange(&node, std::memory_order_acq_rel);
+        if (pred) {
+            pred->next.store(&node, std::memory_order_release);
+            while (node.locked.load(std::memory_order_acquire)) {
+                cpuRelax();
+            }
+        }
+
+        // head of the queue: compete for the word with any TTAS stragglers
+        while (locked.load(std::memory_order_relaxed) ||
+               locked.exchange(true, std::memory_order_acquire)) {
+            cpuRelax();
+        }
+
+        // pass the head on; 'node' dies when we return
+        MCSLock::QNode* next = node.next.load(std::memory_order_acquire);
+        if (!next) {
+            MCSLock::QNode* expected = &node;
+            if (tail.compare_exchange_strong(expected, nullptr,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+                adapt(failures, true);
+                return;
+            }
+            while (!(next = node.next.load(std::memory_order_acquire))) {
+                cpuRelax();
+            }
+        }
+        next->locked.store(false, std::memory_order_release);
+        adapt(failures, false);
+    }
+
+    /* Called by the holder only. 'failures' are the holder's failed
+     * exchanges in TTAS mode, 'alone' whether nobody queued behind it. */
+    void adapt(unsigned failures, bool alone) {
+        if (!queued.load(std::memory_order_relaxed)) {
+            score = failures ? std::min(score + failures, QUEUE_THRESHOLD) : score - (score > 0);
+            if (score >= QUEUE_THRESHOLD) {
+                queued.store(true, std::memory_order_relaxed);
+                score = 0;
+                switchCount++;
+            }
+        } else {
+            score = alone ? score + 1 : 0;
+            if (score >= QUIET_THRESHOLD) {
+                queued.store(false, std::memory_order_relaxed);
+                score = 0;
+                switchCount++;
+            }
+        }
+    }
+
+    alignas(CACHE_LINE_SIZE) std::atomic_bool locked{false};
+    alignas(CACHE_LINE_SIZE) std::atomic<MCSLock::QNode*> tail{nullptr};
+    alignas(CACHE_LINE_SIZE) std::atomic_bool queued{false};  // read by every arriving thread
+    // protected by 'locked'
+    unsigned score{0};
+    unsigned long switchCount{0};
+};
+static_assert(LockConcept<AdaptiveLock>);
+
+#endif
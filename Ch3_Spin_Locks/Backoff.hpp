@@ -0,0 +1,78 @@
+#ifndef BACKOFF_HPP
+#define BACKOFF_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>  // std::hash
+#include <thread>
+
+#ifdef ENABLE_LOCK_STATS
+/* Number of cpuRelax() calls made by this thread, read by InstrumentedLock
+ * to attribute spin iterations to an acquisition. */
+inline thread_local std::uint64_t spinCount = 0;
+#endif
+
+/* Tells the core we are spinning: on x86 'pause' stops the spin loop from
+ * flooding the pipeline with speculative loads of the lock word. */
+inline void cpuRelax() {
+#ifdef ENABLE_LOCK_STATS
+    spinCount++;
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+/* Cheap, monotonic-enough timestamp for sizing spin waits. Units are
+ * unspecified (TSC ticks on x86), only differences are meaningful. */
+inline std::uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+/* Randomized, bounded exponential backoff. Each call waits a random number
+ * of cpuRelax() rounds in [1, limit] and then doubles limit, up to maxDelay.
+ * Once the limit is saturated the thread also yields, since contention is
+ * high enough that the holder may be waiting for a core. */
+class Backoff {
+public:
+    Backoff(unsigned minDelay, unsigned maxDelay)
+    : limit{std::max(1u, minDelay)},
+      maxDelay{std::max(1u, maxDelay)} {}
+
+    void backoff() {
+        unsigned delay = 1 + nextRandom() % limit;
+        for (unsigned i = 0; i < delay; i++) {
+            cpuRelax();
+        }
+        if (limit >= maxDelay) {
+            std::this_thread::yield();
+        }
+        limit = std::min(maxDelay, 2 * limit);
+    }
+
+private:
+    // xorshift, one stream per thread so waiters do not back off in lockstep
+    static std::uint32_t nextRandom() {
+        thread_local std::uint32_t state =
+            static_cast<std::uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())) | 1;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    unsigned limit;
+    unsigned maxDelay;
+};
+
+#endif
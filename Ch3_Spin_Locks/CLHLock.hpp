@@ -0,0 +1,64 @@
+#ifndef CLH_LOCK_HPP
+#define CLH_LOCK_HPP
+
+#include <atomic>
+#include "Backoff.hpp"    // cpuRelax
+#include "CacheLine.hpp"
+#include "Concepts.hpp"
+#include "NodeCache.hpp"
+
+/* CLH queue lock. Waiters form an implicit linked list through 'tail': each
+ * thread enqueues its own node and spins on its predecessor's node, so every
+ * waiter spins on a different cache line and the lock is granted FIFO.
+ *
+ * Works for any number of threads. The lock itself is one tail pointer plus
+ * the holder's node; nodes are kept in a per-thread cache and, as in the
+ * textbook version, a thread reuses its predecessor's node after unlocking,
+ * so lock()/unlock() only allocate the first time a thread needs a node. */
+class CLHLock {
+public:
+    CLHLock() {
+        tail.store(new QNode{}, std::memory_order_relaxed);  // unlocked sentinel
+    }
+
+    CLHLock(const CLHLock&) = delete;
+    CLHLock& operator=(const CLHLock&) = delete;
+
+    ~CLHLock() {
+        // no one holds or waits for the lock, so the tail node is unowned
+        delete tail.load(std::memory_order_relaxed);
+    }
+
+    void lock() {
+        QNode* node = NodeCache<QNode>::local().get();
+        node->locked.store(true, std::memory_order_relaxed);
+        // release: publishes 'locked' before any successor can see the node
+        QNode* pred = tail.exchange(node, std::memory_order_acq_rel);
+        while (pred->locked.load(std::memory_order_acquire)) {
+            cpuRelax();
+        }
+        node->pred = pred;
+        holder = node;
+    }
+
+    void unlock() {
+        QNode* node = holder;
+        QNode* pred = node->pred;
+        node->locked.store(false, std::memory_order_release);
+        // nobody else spins on pred anymore: recycle it as our next node
+        NodeCache<QNode>::local().put(pred);
+    }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) QNode {
+        std::atomic_bool locked{false};
+        QNode* pred{nullptr};
+        QNode* nextFree{nullptr};
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<QNode*> tail;
+    QNode* holder{nullptr};  // only read/written by the thread holding the lock
+};
+static_assert(LockConcept<CLHLock>);
+
+#endif
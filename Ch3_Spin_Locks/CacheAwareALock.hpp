@@ -1,44 +1,59 @@
 #ifndef CACHE_AWARE_ALOCK_HPP
 #define CACHE_AWARE_ALOCK_HPP
 
-#include <new>  // std::hardware_destructive_interference_size
-#include <array>
 #include <atomic>
-#include <iostream>
+#include <bit>      // bit_ceil
+#include <cstddef>
+#include <memory>   // unique_ptr
+#include "Backoff.hpp"    // cpuRelax
+#include "CacheLine.hpp"
+
+/* Same algorithm as ALock, but every slot (and the tail counter) sits on
+ * its own cache line, so a release only invalidates the line the next
+ * waiter is spinning on. */
+class CacheAwareALock {
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 64;
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Winterference-size"
+    /* Handle returned by lock(), must be passed to the matching unlock() */
+    struct Slot {
+        std::size_t ticket{0};
+    };
 
-#define CACHE_LINE_SIZE std::hardware_destructive_interference_size
-#define MAX_NO_THREADS 8
+    explicit CacheAwareALock(std::size_t capacity = DEFAULT_CAPACITY)
+    : mask{std::bit_ceil(capacity) - 1},
+      ready{std::make_unique<ArrElem[]>(mask + 1)} {
+        for (std::size_t i = 0; i <= mask; i++) {
+            ready[i].turn.store(i - (mask + 1), std::memory_order_relaxed);
+        }
+        ready[0].turn.store(0, std::memory_order_relaxed);
+    }
 
-class CacheAwareALock {
-public:
-    CacheAwareALock() {
-       ready[0] = {true};
+    Slot lock() {
+        std::size_t ticket = tail.fetch_add(1, std::memory_order_relaxed);
+        while (ready[ticket & mask].turn.load(std::memory_order_acquire) != ticket) {
+            cpuRelax();
+        }
+        return Slot{ticket};
     }
 
-    int lock() {
-        int slot = (tail++) % MAX_NO_THREADS;
-        while (!ready[slot].flag) {}
-        return slot;
+    void unlock(const Slot slot) {
+        std::size_t next = slot.ticket + 1;
+        ready[next & mask].turn.store(next, std::memory_order_release);
     }
 
-    void unlock(const int slot) {
-        ready[slot] = {false};
-        ready[(slot+1) % MAX_NO_THREADS] = {true};
+    std::size_t capacity() const {
+        return mask + 1;
     }
 
 private:
     struct alignas(CACHE_LINE_SIZE) ArrElem {
-        bool flag;
+        std::atomic<std::size_t> turn{0};
     };
 
-    std::array<ArrElem, MAX_NO_THREADS> ready;
-    alignas(CACHE_LINE_SIZE) std::atomic_int tail{0}; 
+    std::size_t mask;
+    std::unique_ptr<ArrElem[]> ready;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tail{0};
 };
 
-#pragma GCC diagnostic pop
-
 #endif
-
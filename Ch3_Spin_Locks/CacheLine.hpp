@@ -0,0 +1,16 @@
+#ifndef CACHE_LINE_HPP
+#define CACHE_LINE_HPP
+
+#include <cstddef>
+#include <new>  // std::hardware_destructive_interference_size
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+
+/* Padding/alignment used to keep independently written fields from
+ * sharing a cache line (see CacheAlignmentTest.cpp). */
+inline constexpr std::size_t CACHE_LINE_SIZE = std::hardware_destructive_interference_size;
+
+#pragma GCC diagnostic pop
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef COHORT_LOCK_HPP
+#define COHORT_LOCK_HPP
+
+#include <memory>  // unique_ptr
+#include "CacheLine.hpp"
+#include "Concepts.hpp"
+#include "Numa.hpp"
+#include "TicketLock.hpp"
+
+/* NUMA-aware cohort lock (Dice, Marathe & Shavit). Each NUMA node has its
+ * own local lock, and the nodes compete for one global lock. A thread first
+ * takes its node's local lock; if its cohort does not already own the
+ * global lock it takes that too.
+ *
+ * On release, if another thread of the same node is queued on the local
+ * lock, the global lock is passed along with the local one, so the
+ * protected data stays in that node's caches. After batchLimit consecutive
+ * local handoffs the global lock is released anyway so other nodes are not
+ * starved.
+ *
+ * Both levels are TicketLocks: FIFO within a node, and thread-oblivious, so
+ * the global lock can be released by a different thread than the one that
+ * acquired it. On a single-node machine this is a TicketLock with one extra
+ * (uncontended) lock on the global level. */
+class CohortLock {
+public:
+    static constexpr unsigned DEFAULT_BATCH_LIMIT = 64;
+
+    explicit CohortLock(unsigned batchLimit = DEFAULT_BATCH_LIMIT)
+    : batchLimit{batchLimit},
+      cohorts{std::make_unique<Cohort[]>(NumaTopology::get().numNodes())} {}
+
+    void lock() {
+        unsigned node = NumaTopology::get().currentNode();
+        Cohort& cohort = cohorts[node];
+        cohort.local.lock();
+        if (!cohort.ownsGlobal) {
+            global.lock();
+            cohort.ownsGlobal = true;
+        }
+        holderNode = node;
+    }
+
+    void unlock() {
+        Cohort& cohort = cohorts[holderNode];
+        if (cohort.local.hasWaiters() && cohort.batch < batchLimit) {
+            cohort.batch++;  // keep the global lock within the cohort
+        } else {
+            cohort.batch = 0;
+            cohort.ownsGlobal = false;
+            global.unlock();
+        }
+        cohort.local.unlock();
+    }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Cohort {
+        TicketLock local;
+        // protected by 'local'
+        bool ownsGlobal{false};
+        unsigned batch{0};  // local handoffs since the cohort took the global lock
+    };
+
+    unsigned batchLimit;
+    std::unique_ptr<Cohort[]> cohorts;
+    TicketLock global;
+    unsigned holderNode{0};  // only read/written by the thread holding the lock
+};
+static_assert(LockConcept<CohortLock>);
+
+#endif
@@ -0,0 +1,231 @@
+#include <climits>  // INT_MAX
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "LockBenchmark.hpp"
+#include "TASlock.hpp"
+#include "CacheAwareALock.hpp"
+#include "SlotLock.hpp"
+#include "LockedState.hpp"
+#include "FlatCombiner.hpp"
+#include "Delegator.hpp"
+#include "CoarseList.hpp"
+
+/* Compares flat combining and delegation against lock-per-operation on the
+ * two workloads where they should pay off: a shared counter (ScalingCounter's
+ * workload) and a small sorted-list set. Every implementation sits behind
+ * ExecutorConcept's apply(), plain locks through LockedState, and protects
+ * the same unsynchronized SortedList, so the rows differ only in how the
+ * operations are serialized. CoarseList from LinkedLists/ (the same
+ * algorithm with its own std::mutex and shared_ptr nodes) is the
+ * "own lock" baseline.
+ *
+ * Writes CSV: workload,impl,threads,ncs_work,ops,seconds,throughput,correct */
+
+constexpr int KEY_RANGE = 512;
+
+template <ExecutorConcept<std::uint64_t> E>
+WorkloadResult counterWorkload(const BenchConfig& config) {
+    E counter;
+    std::int64_t net;
+    WorkloadResult r = runWorkload(config, [&](std::uint32_t&) {
+        counter.apply([](std::uint64_t& c) { c++; });
+        return 1;
+    }, net);
+    r.correct = counter.apply([](std::uint64_t& c) { return c; }) == r.ops;
+    return r;
+}
+
+/* Sequential sorted linked list of ints between two sentinels, CoarseList's
+ * algorithm without its lock or reference counts; the caller serializes */
+class SortedList {
+public:
+    SortedList() : head{new Node{INT_MIN, new Node{INT_MAX, nullptr}}} {}
+
+    ~SortedList() {
+        while (head) {
+            Node* next = head->next;
+            delete head;
+            head = next;
+        }
+    }
+
+    SortedList(const SortedList&) = delete;
+    SortedList& operator=(const SortedList&) = delete;
+
+    bool add(int key) {
+        Node* pred = find(key);
+        if (pred->next->key == key) {
+            return false;
+        }
+        pred->next = new Node{key, pred->next};
+        return true;
+    }
+
+    bool remove(int key) {
+        Node* pred = find(key);
+        Node* curr = pred->next;
+        if (curr->key != key) {
+            return false;
+        }
+        pred->next = curr->next;
+        delete curr;
+        return true;
+    }
+
+    bool contains(int key) {
+        return find(key)->next->key == key;
+    }
+
+private:
+    struct Node {
+        int key;
+        Node* next;
+    };
+
+    /* The last node with a key below 'key' */
+    Node* find(int key) {
+        Node* pred = head;
+        while (pred->next->key < key) {
+            pred = pred->next;
+        }
+        return pred;
+    }
+
+    Node* head;
+};
+
+/* Half adds, half removes of random keys */
+template <typename List, typename Apply>
+int listOp(std::uint32_t& rng, Apply apply) {
+    std::uint32_t x = nextRandom(rng);
+    int key = (x >> 1) % KEY_RANGE;
+    if (x & 1) {
+        return apply([key](List& list) { return list.add(key) ? 1 : 0; });
+    }
+    return apply([key](List& list) { return list.remove(key) ? -1 : 0; });
+}
+
+template <typename List>
+bool checkList(List& list, std::int64_t net) {
+    std::int64_t present = 0;
+    for (int key = 0; key < KEY_RANGE; key++) {
+        present += list.contains(key);
+    }
+    return present == net;
+}
+
+/* CoarseList on its own, i.e. its internal std::mutex per operation */
+WorkloadResult plainList(const BenchConfig& config) {
+    CoarseList<int> list;
+    std::int64_t net;
+    WorkloadResult r = runWorkload(config, [&](std::uint32_t& rng) {
+        return listOp<CoarseList<int>>(rng, [&](auto f) { return f(list); });
+    }, net);
+    r.correct = checkList(list, net);
+    return r;
+}
+
+template <ExecutorConcept<SortedList> E>
+WorkloadResult listWorkload(const BenchConfig& config) {
+    E list;
+    std::int64_t net;
+    WorkloadResult r = runWorkload(config, [&](std::uint32_t& rng) {
+        return listOp<SortedList>(rng, [&](auto f) { return list.apply(f); });
+    }, net);
+    r.correct = list.apply([net](SortedList& l) { return checkList(l, net); });
+    return r;
+}
+
+struct Entry {
+    const char* workload;
+    const char* impl;
+    WorkloadResult (*run)(const BenchConfig&);
+};
+
+template <typename L>
+using LockedCounter = LockedState<L, std::uint64_t>;
+template <typename L>
+using LockedList = LockedState<L, SortedList>;
+
+const Entry ENTRIES[] = {
+    {"counter", "TAS",             counterWorkload<LockedCounter<TASlock>>},
+    {"counter", "TTAS",            counterWorkload<LockedCounter<TTASlock>>},
+    {"counter", "CacheAwareALock", counterWorkload<LockedCounter<SlotLock<CacheAwareALock>>>},
+    {"counter", "FlatCombiner",    counterWorkload<FlatCombiner<std::uint64_t>>},
+    {"counter", "Delegator",       counterWorkload<Delegator<std::uint64_t>>},
+    {"list",    "CoarseList",      plainList},
+    {"list",    "TAS",             listWorkload<LockedList<TASlock>>},
+    {"list",    "TTAS",            listWorkload<LockedList<TTASlock>>},
+    {"list",    "CacheAwareALock", listWorkload<LockedList<SlotLock<CacheAwareALock>>>},
+    {"list",    "FlatCombiner",    listWorkload<FlatCombiner<SortedList>>},
+    {"list",    "Delegator",       listWorkload<Delegator<SortedList>>},
+};
+
+std::string getUsageString() {
+    return std::string("USAGE:\n") +
+           "\t'./combining_bench [-t THREADS] [-n NCS_WORK] [-d MS]'\n" +
+           "\t - THREADS, NCS_WORK are comma-separated sweeps (default 1,2,4,8 / 0)\n" +
+           "\t - MS is the duration of each run in milliseconds (default 200)\n";
+}
+
+int main(int argc, char** argv) {
+    std::vector<unsigned> threads{1, 2, 4, 8};
+    std::vector<unsigned> ncsWork{0};
+    BenchConfig config;
+
+    if (argc % 2 == 0) {
+        std::cerr << getUsageString();
+        return -1;
+    }
+    for (int i = 1; i < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i+1];
+        if (flag == "-t") {
+            threads = parseThreadList(value);
+            if (threads.empty()) {
+                std::cerr << "THREADS must be at least 1\n" << getUsageString();
+                return -1;
+            }
+        } else if (flag == "-n") {
+            ncsWork = parseList(value);
+        } else if (flag == "-d") {
+            config.duration = std::chrono::milliseconds{std::stoul(value)};
+        } else {
+            std::cerr << getUsageString();
+            return -1;
+        }
+    }
+
+    bool allCorrect = true;
+    std::printf("workload,impl,threads,ncs_work,ops,seconds,throughput,correct\n");
+    for (const Entry& entry : ENTRIES) {
+        for (unsigned t : threads) {
+            for (unsigned ncs : ncsWork) {
+                config.numThreads = t;
+                config.ncsWork = ncs;
+                WorkloadResult r = entry.run(config);
+                std::printf("%s,%s,%u,%u,%llu,%.4f,%.0f,%d\n",
+                            entry.workload,
+                            entry.impl,
+                            t,
+                            ncs,
+                            (unsigned long long) r.ops,
+                            r.seconds,
+                            r.ops / r.seconds,
+                            r.correct ? 1 : 0);
+                std::fflush(stdout);
+                if (!r.correct) {
+                    std::cerr << entry.workload << "/" << entry.impl
+                              << ": result inconsistent with " << t << " threads" << std::endl;
+                    allCorrect = false;
+                }
+            }
+        }
+    }
+
+    return allCorrect ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "LockBenchmark.hpp"
+#include "TASlock.hpp"
+#include "ScalableCounter.hpp"
+
+/* Shared counters the way metrics code uses them: mostly increments, some
+ * reads. Compares a lock-protected int (the old ScalingCounter), a single
+ * fetch_add atomic and the striped counters from ScalableCounter.hpp, plus
+ * SNZI against a plain atomic count for "is anyone active" checks.
+ *
+ * Writes CSV: workload,impl,threads,read_pct,ops,seconds,throughput,correct,
+ * with the hardware counter columns before 'correct' under -p 1. */
+
+/* Each op is a read with probability readPercent, an increment otherwise;
+ * returns 1 for increments so runWorkload's net change is the expected total */
+template <typename Inc, typename Read>
+WorkloadResult counterWorkload(const BenchConfig& config, Inc increment, Read read,
+                               std::int64_t& expected) {
+    return runWorkload(config, [&](std::uint32_t& rng) {
+        if (config.readPercent && nextRandom(rng) % 100 < config.readPercent) {
+            volatile std::int64_t value = read();
+            (void) value;
+            return 0;
+        }
+        increment();
+        return 1;
+    }, expected);
+}
+
+template <LockConcept L>
+WorkloadResult lockedCounter(const BenchConfig& config) {
+    L mutex;
+    std::int64_t counter = 0;
+    std::int64_t expected;
+    WorkloadResult r = counterWorkload(config,
+        [&]() { mutex.lock(); counter++; mutex.unlock(); },
+        [&]() { mutex.lock(); std::int64_t c = counter; mutex.unlock(); return c; },
+        expected);
+    r.correct = counter == expected;
+    return r;
+}
+
+WorkloadResult atomicCounter(const BenchConfig& config) {
+    alignas(CACHE_LINE_SIZE) std::atomic<std::int64_t> counter{0};
+    std::int64_t expected;
+    WorkloadResult r = counterWorkload(config,
+        [&]() { counter.fetch_add(1, std::memory_order_relaxed); },
+        [&]() { return counter.load(std::memory_order_relaxed); },
+        expected);
+    r.correct = counter.load() == expected;
+    return r;
+}
+
+WorkloadResult scalableCounter(const BenchConfig& config) {
+    ScalableCounter counter;
+    std::int64_t expected;
+    WorkloadResult r = counterWorkload(config,
+        [&]() { counter.increment(); },
+        [&]() { return counter.read(); },
+        expected);
+    r.correct = counter.read() == expected;
+    return r;
+}
+
+WorkloadResult approximateCounter(const BenchConfig& config) {
+    ApproximateCounter counter;
+    std::int64_t expected;
+    WorkloadResult r = counterWorkload(config,
+        [&]() { counter.increment(); },
+        [&]() { return counter.readApprox(); },
+        expected);
+    r.correct = counter.read() == expected;
+    return r;
+}
+
+/* Every op is an arrive/depart pair, with a query by the same share of ops
+ * that read in the counter workloads. A query inside the pair must see
+ * someone active, and nobody is active once the threads are done. */
+template <typename Arrive, typename Depart, typename Query>
+WorkloadResult activeWorkload(const BenchConfig& config, Arrive arrive, Depart depart,
+                              Query query) {
+    std::atomic_bool missed{false};
+    std::int64_t net;
+    WorkloadResult r = runWorkload(config, [&](std::uint32_t& rng) {
+        arrive();
+        if (config.readPercent && nextRandom(rng) % 100 < config.readPercent && !query()) {
+            missed.store(true, std::memory_order_relaxed);
+        }
+        depart();
+        return 0;
+    }, net);
+    r.correct = !missed.load() && !query();
+    return r;
+}
+
+WorkloadResult atomicActive(const BenchConfig& config) {
+    alignas(CACHE_LINE_SIZE) std::atomic<std::int64_t> active{0};
+    return activeWorkload(config,
+        [&]() { active.fetch_add(1, std::memory_order_acquire); },
+        [&]() { active.fetch_sub(1, std::memory_order_release); },
+        [&]() { return active.load(std::memory_order_acquire) != 0; });
+}
+
+WorkloadResult snziActive(const BenchConfig& config) {
+    SNZI snzi;
+    return activeWorkload(config,
+        [&]() { snzi.arrive(); },
+        [&]() { snzi.depart(); },
+        [&]() { return snzi.query(); });
+}
+
+struct Entry {
+    const char* workload;
+    const char* impl;
+    WorkloadResult (*run)(const BenchConfig&);
+};
+
+const Entry ENTRIES[] = {
+    {"counter", "TTAS",        lockedCounter<TTASlock>},
+    {"counter", "fetch_add",   atomicCounter},
+    {"counter", "Scalable",    scalableCounter},
+    {"counter", "Approximate", approximateCounter},
+    {"active",  "fetch_add",   atomicActive},
+    {"active",  "SNZI",        snziActive},
+};
+
+std::string getUsageString() {
+    return std::string("USAGE:\n") +
+           "\t'./counter_bench [-t THREADS] [-r READ_PCT] [-d MS] [-p 0|1]'\n" +
+           "\t - THREADS, READ_PCT are comma-separated sweeps (default 1,2,4,8,16,32,64 / 0,10)\n" +
+           "\t - READ_PCT is the share of ops that read the counter (or query the SNZI)\n" +
+           "\t - MS is the duration of each run in milliseconds (default 200)\n" +
+           "\t - '-p 1' adds hardware counters per run, e.g. the cache misses of the\n" +
+           "\t   striped counters against fetch_add on one line\n";
+}
+
+int main(int argc, char** argv) {
+    std::vector<unsigned> threads{1, 2, 4, 8, 16, 32, 64};
+    std::vector<unsigned> readPercents{0, 10};
+    BenchConfig config;
+
+    if (argc % 2 == 0) {
+        std::cerr << getUsageString();
+        return -1;
+    }
+    for (int i = 1; i < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i+1];
+        if (flag == "-t") {
+            threads = parseThreadList(value);
+            if (threads.empty()) {
+                std::cerr << "THREADS must be at least 1\n" << getUsageString();
+                return -1;
+            }
+        } else if (flag == "-r") {
+            readPercents = parseList(value);
+        } else if (flag == "-d") {
+            config.duration = std::chrono::milliseconds{std::stoul(value)};
+        } else if (flag == "-p") {
+            config.perfCounters = std::stoul(value) != 0 && perfCountersAvailable();
+        } else {
+            std::cerr << getUsageString();
+            return -1;
+        }
+    }
+
+    bool allCorrect = true;
+    std::printf("workload,impl,threads,read_pct,ops,seconds,throughput,");
+    if (config.perfCounters) {
+        printPerfHeader(stdout);
+    }
+    std::printf("correct\n");
+    for (const Entry& entry : ENTRIES) {
+        for (unsigned t : threads) {
+            for (unsigned read : readPercents) {
+                config.numThreads = t;
+                config.readPercent = read;
+                WorkloadResult r = entry.run(config);
+                std::printf("%s,%s,%u,%u,%llu,%.4f,%.0f,",
+                            entry.workload,
+                            entry.impl,
+                            t,
+                            read,
+                            (unsigned long long) r.ops,
+                            r.seconds,
+                            r.ops / r.seconds);
+                if (config.perfCounters) {
+                    printPerfFields(stdout, r.perf);
+                }
+                std::printf("%d\n", r.correct ? 1 : 0);
+                std::fflush(stdout);
+                if (!r.correct) {
+                    std::cerr << entry.workload << "/" << entry.impl
+                              << ": result inconsistent with " << t << " threads" << std::endl;
+                    allCorrect = false;
+                }
+            }
+        }
+    }
+
+    return allCorrect ? 0 : 1;
+}
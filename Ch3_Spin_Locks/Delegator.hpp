@@ -0,0 +1,142 @@
+#ifndef DELEGATOR_HPP
+#define DELEGATOR_HPP
+
+#include <atomic>
+#include <memory>       // unique_ptr
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>      // forward, move
+#include "Backoff.hpp"  // cpuRelax
+#include "CacheLine.hpp"
+#include "Concepts.hpp"
+#include "ThreadIndex.hpp"
+
+/* Delegation: the state belongs to one dedicated server thread, and every
+ * other thread ships its critical section to it instead of taking a lock.
+ * The data never leaves the server's cache; what moves between cores is one
+ * request line per operation.
+ *
+ *     Delegator<std::uint64_t> counter;  // starts the server thread
+ *     counter.apply([](std::uint64_t& c) { c++; });
+ *     std::uint64_t value = counter.apply([](std::uint64_t& c) { return c; });
+ *
+ * Each client has a cache-line slot (picked by ThreadIndex) holding a
+ * pointer to its request. The server polls the slots round robin, runs each
+ * request and clears the slot, which is also the response: the client
+ * spins on its own slot line until the pointer it posted is gone.
+ *
+ * Like FlatCombiner, operations run on another thread, so they must not
+ * throw, must not rely on thread-local state and must not call apply()
+ * themselves. The server burns its core while idle (it yields after a
+ * while), which is the price of delegation. */
+template <typename State>
+class Delegator {
+public:
+    static constexpr unsigned MAX_THREADS = 256;  // more clients share slots, by mask
+    static constexpr unsigned CLIENT_SPIN = 1024;  // cpuRelax()es before a client starts yielding
+    static constexpr unsigned SERVER_SPIN = 1024;  // empty scans before the server starts yielding
+
+    template <typename... Args>
+    explicit Delegator(Args&&... args) : state(std::forward<Args>(args)...) {
+        server = std::thread{[this]() { serve(); }};
+    }
+
+    ~Delegator() {
+        running.store(false, std::memory_order_relaxed);
+        server.join();
+    }
+
+    Delegator(const Delegator&) = delete;
+    Delegator& operator=(const Delegator&) = delete;
+
+    /* Runs f(state) on the server thread and returns its result */
+    template <typename F>
+    auto apply(F&& f) {
+        using R = std::invoke_result_t<F&, State&>;
+        if constexpr (std::is_void_v<R>) {
+            execute([&f](State& s) { f(s); });
+        } else {
+            std::optional<R> result;
+            execute([&f, &result](State& s) { result.emplace(f(s)); });
+            return std::move(*result);
+        }
+    }
+
+private:
+    struct Request {
+        void (*run)(State&, void*);
+        void* op;
+    };
+
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        std::atomic<Request*> request{nullptr};
+    };
+
+    template <typename Op>
+    static void invoke(State& s, void* op) {
+        (*static_cast<Op*>(op))(s);
+    }
+
+    template <typename Op>
+    void execute(Op&& op) {
+        unsigned index = ThreadIndex::get() & (MAX_THREADS - 1);
+        ThreadIndex::raiseHighWater(activeSlots, index);  // the server scans slots below activeSlots
+        Slot& slot = slots[index];
+
+        Request request{&invoke<std::remove_reference_t<Op>>, &op};
+        // only contended when more than MAX_THREADS clients share slots
+        Request* expected = nullptr;
+        for (unsigned i = 0; !slot.request.compare_exchange_weak(expected, &request,
+                                                                 std::memory_order_release,
+                                                                 std::memory_order_relaxed); i++) {
+            expected = nullptr;
+            pause(i);
+        }
+        // the server swaps our pointer out once the op has run
+        for (unsigned i = 0; slot.request.load(std::memory_order_acquire) == &request; i++) {
+            pause(i);
+        }
+    }
+
+    static void pause(unsigned i) {
+        if (i < CLIENT_SPIN) {
+            cpuRelax();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    void serve() {
+        unsigned idle = 0;
+        while (running.load(std::memory_order_relaxed)) {
+            bool found = false;
+            unsigned numSlots = activeSlots.load(std::memory_order_acquire);
+            for (unsigned i = 0; i < numSlots; i++) {
+                Request* request = slots[i].request.load(std::memory_order_acquire);
+                if (request) {
+                    request->run(state, request->op);
+                    // after this store the client may return and destroy 'request'
+                    slots[i].request.store(nullptr, std::memory_order_release);
+                    found = true;
+                }
+            }
+            if (found) {
+                idle = 0;
+            } else if (++idle < SERVER_SPIN) {
+                cpuRelax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    std::unique_ptr<Slot[]> slots{std::make_unique<Slot[]>(MAX_THREADS)};
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> activeSlots{0};
+    std::atomic_bool running{true};
+    alignas(CACHE_LINE_SIZE) State state;  // touched by the server thread only
+    std::thread server;
+};
+static_assert(ExecutorConcept<Delegator<int>, int>);
+
+#endif
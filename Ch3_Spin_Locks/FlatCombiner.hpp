@@ -0,0 +1,129 @@
+#ifndef FLAT_COMBINER_HPP
+#define FLAT_COMBINER_HPP
+
+#include <atomic>
+#include <memory>       // unique_ptr
+#include <optional>
+#include <type_traits>
+#include <utility>      // forward, move
+#include "Backoff.hpp"  // cpuRelax
+#include "CacheLine.hpp"
+#include "Concepts.hpp"
+#include "ThreadIndex.hpp"
+
+/* Flat combining (Hendler, Incze, Shavit & Tzafrir). Instead of every thread
+ * taking a lock to run its own small critical section, each thread posts
+ * its operation in its own publication slot, and whichever thread manages
+ * to take the combiner lock runs every posted operation in one pass. The
+ * state stays in the combiner's cache for the whole batch, and the lock
+ * changes hands once per batch instead of once per operation.
+ *
+ *     FlatCombiner<std::uint64_t> counter;
+ *     counter.apply([](std::uint64_t& c) { c++; });
+ *     std::uint64_t value = counter.apply([](std::uint64_t& c) { return c; });
+ *
+ * Operations run on whichever thread is combining, so they must not throw
+ * and must not rely on thread-local state. Threads with a ThreadIndex beyond
+ * MAX_THREADS have no slot and simply take the combiner lock themselves. */
+template <typename State>
+class FlatCombiner {
+public:
+    static constexpr unsigned MAX_THREADS = 256;
+    static constexpr unsigned MAX_PASSES = 4;  // scans per combining session while work keeps arriving
+
+    template <typename... Args>
+    explicit FlatCombiner(Args&&... args) : state(std::forward<Args>(args)...) {}
+
+    /* Runs f(state) with exclusive access to the state and returns its result */
+    template <typename F>
+    auto apply(F&& f) {
+        using R = std::invoke_result_t<F&, State&>;
+        if constexpr (std::is_void_v<R>) {
+            execute([&f](State& s) { f(s); });
+        } else {
+            std::optional<R> result;
+            execute([&f, &result](State& s) { result.emplace(f(s)); });
+            return std::move(*result);
+        }
+    }
+
+private:
+    struct Request {
+        void (*run)(State&, void*);
+        void* op;
+        std::atomic_bool done{false};
+    };
+
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        std::atomic<Request*> request{nullptr};
+    };
+
+    template <typename Op>
+    static void invoke(State& s, void* op) {
+        (*static_cast<Op*>(op))(s);
+    }
+
+    template <typename Op>
+    void execute(Op&& op) {
+        unsigned index = ThreadIndex::get();
+        if (index >= MAX_THREADS) {
+            while (!tryLockCombiner()) {
+                cpuRelax();
+            }
+            op(state);
+            unlockCombiner();
+            return;
+        }
+        ThreadIndex::raiseHighWater(activeSlots, index);  // the combiner scans slots below activeSlots
+
+        Request request{&invoke<std::remove_reference_t<Op>>, &op};
+        slots[index].request.store(&request, std::memory_order_release);
+        while (!request.done.load(std::memory_order_acquire)) {
+            if (tryLockCombiner()) {
+                combine();
+                unlockCombiner();
+                // our own request was posted before we got the lock, so it is done now
+            } else {
+                cpuRelax();
+            }
+        }
+    }
+
+    /* TTAS on the combiner flag */
+    bool tryLockCombiner() {
+        return !combining.load(std::memory_order_relaxed) &&
+               !combining.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlockCombiner() {
+        combining.store(false, std::memory_order_release);
+    }
+
+    void combine() {
+        unsigned numSlots = activeSlots.load(std::memory_order_acquire);
+        for (unsigned pass = 0; pass < MAX_PASSES; pass++) {
+            bool found = false;
+            for (unsigned i = 0; i < numSlots; i++) {
+                Request* request = slots[i].request.load(std::memory_order_acquire);
+                if (request) {
+                    request->run(state, request->op);
+                    slots[i].request.store(nullptr, std::memory_order_relaxed);
+                    // after this store the owner may return and destroy 'request'
+                    request->done.store(true, std::memory_order_release);
+                    found = true;
+                }
+            }
+            if (!found) {
+                return;
+            }
+        }
+    }
+
+    std::unique_ptr<Slot[]> slots{std::make_unique<Slot[]>(MAX_THREADS)};
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> activeSlots{0};
+    std::atomic_bool combining{false};
+    alignas(CACHE_LINE_SIZE) State state;
+};
+static_assert(ExecutorConcept<FlatCombiner<int>, int>);
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <array>
+#include <atomic>
+#include <bit>      // bit_width
+#include <cstddef>
+#include <cstdint>
+
+/* Log-linear (HDR-style) histogram of 64-bit values. Values below 32 get a
+ * bucket each; above that every power of two is split into 16 linear
+ * sub-buckets, so a recorded value is off by at most 1/16 (~6%) and the
+ * whole 64-bit range fits in under a thousand buckets. */
+struct HistogramLayout {
+    static constexpr unsigned SUB_BITS = 5;
+    static constexpr std::uint64_t SUB_COUNT = 1 << SUB_BITS;   // 32
+    static constexpr std::uint64_t HALF_COUNT = SUB_COUNT / 2;  // 16
+    static constexpr std::size_t NUM_BUCKETS = SUB_COUNT + (64 - SUB_BITS) * HALF_COUNT;
+
+    static std::size_t bucketOf(std::uint64_t value) {
+        if (value < SUB_COUNT) {
+            return value;
+        }
+        // shift so that the top SUB_BITS bits remain, i.e. top in [16, 32)
+        unsigned shift = std::bit_width(value) - SUB_BITS;
+        std::uint64_t top = value >> shift;
+        return SUB_COUNT + (shift - 1) * HALF_COUNT + (top - HALF_COUNT);
+    }
+
+    /* Smallest value that falls into 'bucket' */
+    static std::uint64_t lowerBound(std::size_t bucket) {
+        if (bucket < SUB_COUNT) {
+            return bucket;
+        }
+        std::size_t rest = bucket - SUB_COUNT;
+        unsigned shift = rest / HALF_COUNT + 1;
+        std::uint64_t top = rest % HALF_COUNT + HALF_COUNT;
+        return top << shift;
+    }
+};
+
+/* Plain counts, used for merged snapshots. */
+class HistogramSnapshot {
+public:
+    void add(std::size_t bucket, std::uint64_t count) {
+        counts[bucket] += count;
+        total += count;
+    }
+
+    void merge(const HistogramSnapshot& other) {
+        for (std::size_t i = 0; i < counts.size(); i++) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+    }
+
+    std::uint64_t count() const {
+        return total;
+    }
+
+    /* Lower bound of the bucket holding the p-th quantile, p in [0, 1] */
+    std::uint64_t percentile(double p) const {
+        if (total == 0) {
+            return 0;
+        }
+        std::uint64_t rank = static_cast<std::uint64_t>(p * (total - 1));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < counts.size(); i++) {
+            seen += counts[i];
+            if (seen > rank) {
+                return HistogramLayout::lowerBound(i);
+            }
+        }
+        return HistogramLayout::lowerBound(counts.size() - 1);
+    }
+
+    double mean() const {
+        if (total == 0) {
+            return 0;
+        }
+        double sum = 0;
+        for (std::size_t i = 0; i < counts.size(); i++) {
+            sum += static_cast<double>(counts[i]) * HistogramLayout::lowerBound(i);
+        }
+        return sum / total;
+    }
+
+private:
+    std::array<std::uint64_t, HistogramLayout::NUM_BUCKETS> counts{};
+    std::uint64_t total{0};
+};
+
+/* Single-writer histogram. The owning thread records with a relaxed
+ * load + store per value (no read-modify-write), and any other thread may
+ * take a snapshot at any time; the snapshot is per-bucket consistent, which
+ * is all a running workload can offer without stopping it. */
+class Histogram {
+public:
+    void record(std::uint64_t value) {
+        std::atomic<std::uint64_t>& bucket = counts[HistogramLayout::bucketOf(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void addTo(HistogramSnapshot& snapshot) const {
+        for (std::size_t i = 0; i < counts.size(); i++) {
+            std::uint64_t count = counts[i].load(std::memory_order_relaxed);
+            if (count) {
+                snapshot.add(i, count);
+            }
+        }
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, HistogramLayout::NUM_BUCKETS> counts{};
+};
+
+#endif
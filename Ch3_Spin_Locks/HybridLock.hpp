@@ -0,0 +1,78 @@
+#ifndef HYBRID_LOCK_HPP
+#define HYBRID_LOCK_HPP
+
+#include <algorithm>
+#include <atomic>
+#include "Backoff.hpp"    // cpuRelax
+#include "CacheLine.hpp"
+#include "Concepts.hpp"
+
+/* Spin-then-park lock. A waiter first spins TTAS-style for a bounded number
+ * of iterations; if the lock is still taken it parks with std::atomic::wait
+ * (a futex on Linux) instead of burning its core.
+ *
+ * The lock word has three states, so unlock() only issues a wake-up when
+ * someone may be sleeping:
+ *   UNLOCKED, LOCKED (no sleepers), CONTENDED (locked, maybe sleepers).
+ *
+ * The spin budget adapts to the hold times: a waiter that gets the lock
+ * while spinning reports how many iterations it took (how much of the hold
+ * it had to sit through), and the budget tracks about twice the running
+ * average of that. When spinning keeps failing, i.e. holds are long, the
+ * estimate decays and waiters park almost straight away. */
+class HybridLock {
+public:
+    static constexpr unsigned MIN_SPIN = 16;
+    static constexpr unsigned MAX_SPIN = 4096;
+
+    void lock() {
+        unsigned expected = UNLOCKED;
+        if (state.compare_exchange_strong(expected, LOCKED,
+                                          std::memory_order_acquire,
+                                          std::memory_order_relaxed)) {
+            return;
+        }
+
+        unsigned estimate = spinEstimate.load(std::memory_order_relaxed);
+        unsigned budget = std::min(MAX_SPIN, MIN_SPIN + 2 * estimate);
+        for (unsigned i = 0; i < budget; i++) {
+            if (state.load(std::memory_order_relaxed) == UNLOCKED) {
+                expected = UNLOCKED;
+                if (state.compare_exchange_strong(expected, LOCKED,
+                                                  std::memory_order_acquire,
+                                                  std::memory_order_relaxed)) {
+                    // running average with weight 1/8, cheap enough to race on
+                    int delta = (int) i - (int) estimate;
+                    spinEstimate.store(estimate + delta / 8, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            cpuRelax();
+        }
+        spinEstimate.store(estimate - estimate / 8, std::memory_order_relaxed);
+
+        // Park. Once we go through here the lock stays CONTENDED until a
+        // release finds no one left to wake, which may cost one spurious notify.
+        while (state.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED) {
+            state.wait(CONTENDED, std::memory_order_relaxed);
+        }
+    }
+
+    void unlock() {
+        if (state.exchange(UNLOCKED, std::memory_order_release) == CONTENDED) {
+            state.notify_one();
+        }
+    }
+
+private:
+    static constexpr unsigned UNLOCKED = 0;
+    static constexpr unsigned LOCKED = 1;
+    static constexpr unsigned CONTENDED = 2;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> state{UNLOCKED};
+    // only written by waiters, kept off the lock word's line
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> spinEstimate{0};
+};
+static_assert(LockConcept<HybridLock>);
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef INSTRUMENTED_LOCK_HPP
+#define INSTRUMENTED_LOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>  // unique_ptr
+#include <string>
+#include <utility>  // forward
+#include "Backoff.hpp"    // spinCount
+#include "CacheLine.hpp"
+#include "Concepts.hpp"
+#include "Histogram.hpp"
+#include "ThreadIndex.hpp"
+#include "TscClock.hpp"
+
+/* Merged view of an InstrumentedLock's per-thread histograms. Times are in
+ * TscClock ticks, see TscClock::toNanos. */
+struct LockStats {
+    HistogramSnapshot wait;     // lock() called -> lock acquired
+    HistogramSnapshot hold;     // lock acquired -> unlock() called
+    HistogramSnapshot spins;    // cpuRelax() calls per acquisition
+    HistogramSnapshot handoff;  // previous owner's unlock -> next owner's acquire,
+                                // for acquisitions that changed owner after waiting
+};
+
+/* Decorator for any LockConcept type that records, per thread and per
+ * acquisition, how long the caller waited, how long it held the lock, how
+ * many spin iterations it made (counted through cpuRelax(), so locks that
+ * spin on an empty loop report 0) and the latency of owner changes.
+ *
+ * Each thread writes only its own histograms, so recording costs two clock
+ * reads and a few uncontended stores; stats() merges all threads while the
+ * workload keeps running.
+ *
+ * Without ENABLE_LOCK_STATS this is just L: lock()/unlock() forward
+ * directly and stats() is empty. */
+template <LockConcept L>
+class InstrumentedLock {
+public:
+    static constexpr unsigned MAX_THREADS = 256;  // threads beyond this are not recorded
+
+    template <typename... Args>
+    explicit InstrumentedLock(Args&&... args) : mutex(std::forward<Args>(args)...) {}
+
+    ~InstrumentedLock() {
+#ifdef ENABLE_LOCK_STATS
+        for (unsigned i = 0; i < MAX_THREADS; i++) {
+            delete threads[i].load(std::memory_order_relaxed);
+        }
+#endif
+    }
+
+#ifdef ENABLE_LOCK_STATS
+    void lock() {
+        std::uint64_t spinsBefore = spinCount;
+        std::uint64_t start = TscClock::now();
+        mutex.lock();
+        std::uint64_t acquired = TscClock::now();
+
+        unsigned index = ThreadIndex::get();
+        ThreadStats* me = statsFor(index);
+        if (me) {
+            me->wait.record(acquired - start);
+            me->spins.record(spinCount - spinsBefore);
+            if (lastOwner != index && lastOwner != NO_OWNER && releasedAt >= start) {
+                me->handoff.record(acquired - releasedAt);
+            }
+        }
+        lastOwner = index;
+        acquiredAt = acquired;
+    }
+
+    void unlock() {
+        std::uint64_t released = TscClock::now();
+        ThreadStats* me = statsFor(lastOwner);
+        if (me) {
+            me->hold.record(released - acquiredAt);
+        }
+        releasedAt = released;
+        mutex.unlock();
+    }
+#else
+    void lock() {
+        mutex.lock();
+    }
+
+    void unlock() {
+        mutex.unlock();
+    }
+#endif
+
+    /* Safe to call from any thread at any time */
+    LockStats stats() const {
+        LockStats merged;
+#ifdef ENABLE_LOCK_STATS
+        for (unsigned i = 0; i < MAX_THREADS; i++) {
+            const ThreadStats* t = threads[i].load(std::memory_order_acquire);
+            if (t) {
+                t->wait.addTo(merged.wait);
+                t->hold.addTo(merged.hold);
+                t->spins.addTo(merged.spins);
+                t->handoff.addTo(merged.handoff);
+            }
+        }
+#endif
+        return merged;
+    }
+
+    /* One CSV row per metric: name,metric,count,mean,p50,p99,p999 (times in ns) */
+    void report([[maybe_unused]] std::FILE* out, [[maybe_unused]] const std::string& name) const {
+#ifdef ENABLE_LOCK_STATS
+        LockStats s = stats();
+        printRow(out, name, "wait_ns", s.wait, TscClock::nanosPerTick());
+        printRow(out, name, "hold_ns", s.hold, TscClock::nanosPerTick());
+        printRow(out, name, "spins", s.spins, 1.0);
+        printRow(out, name, "handoff_ns", s.handoff, TscClock::nanosPerTick());
+#endif
+    }
+
+private:
+#ifdef ENABLE_LOCK_STATS
+    static constexpr unsigned NO_OWNER = ~0u;
+
+    struct alignas(CACHE_LINE_SIZE) ThreadStats {
+        Histogram wait;
+        Histogram hold;
+        Histogram spins;
+        Histogram handoff;
+    };
+
+    /* Allocated the first time a thread uses this lock. Only that thread
+     * (index) ever stores into the slot. */
+    ThreadStats* statsFor(unsigned index) {
+        if (index >= MAX_THREADS) {
+            return nullptr;
+        }
+        ThreadStats* t = threads[index].load(std::memory_order_relaxed);
+        if (!t) {
+            t = new ThreadStats{};
+            threads[index].store(t, std::memory_order_release);
+        }
+        return t;
+    }
+
+    static void printRow(std::FILE* out, const std::string& name, const char* metric,
+                         const HistogramSnapshot& h, double scale) {
+        std::fprintf(out, "%s,%s,%llu,%.1f,%.1f,%.1f,%.1f\n",
+                     name.c_str(),
+                     metric,
+                     (unsigned long long) h.count(),
+                     h.mean() * scale,
+                     h.percentile(0.50) * scale,
+                     h.percentile(0.99) * scale,
+                     h.percentile(0.999) * scale);
+    }
+
+    // written by the holder only
+    unsigned lastOwner{NO_OWNER};
+    std::uint64_t acquiredAt{0};
+    std::uint64_t releasedAt{0};
+    std::unique_ptr<std::atomic<ThreadStats*>[]> threads{
+        std::make_unique<std::atomic<ThreadStats*>[]>(MAX_THREADS)};
+#endif
+
+    L mutex;
+};
+
+#endif
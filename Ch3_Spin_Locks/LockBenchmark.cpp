@@ -0,0 +1,142 @@
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "LockBenchmark.hpp"
+#include "TASlock.hpp"
+#include "ALock.hpp"
+#include "CacheAwareALock.hpp"
+#include "CLHLock.hpp"
+#include "MCSLock.hpp"
+#include "HybridLock.hpp"
+#include "RWLock.hpp"
+#include "TicketLock.hpp"
+#include "CohortLock.hpp"
+#include "InstrumentedLock.hpp"
+#include "SlotLock.hpp"
+#include "Peterson.hpp"
+#include "TournamentLock.hpp"
+#include "AdaptiveLock.hpp"
+
+struct LockEntry {
+    const char* name;
+    int maxThreads;  // 0 == no limit
+    BenchResult (*run)(const std::string&, const BenchConfig&);
+};
+
+const LockEntry LOCKS[] = {
+    {"TAS",             0,              runBenchmark<TASlock>},
+    {"TTAS",            0,              runBenchmark<TTASlock>},
+    {"Backoff",         0,              runBenchmark<BackoffLock<>>},
+    {"Ticket",          0,              runBenchmark<TicketLock>},
+    {"Cohort",          0,              runBenchmark<CohortLock>},
+    {"ALock",           0,              runBenchmark<SlotLock<ALock>>},
+    {"CacheAwareALock", 0,              runBenchmark<SlotLock<CacheAwareALock>>},
+    {"CLH",             0,              runBenchmark<CLHLock>},
+    {"MCS",             0,              runBenchmark<MCSLock>},
+    {"Hybrid",          0,              runBenchmark<HybridLock>},
+    {"Adaptive",        0,              runBenchmark<AdaptiveLock>},
+    {"TTASRW",          0,              runBenchmark<TTASRWLock>},
+    {"WriterPrefRW",    0,              runBenchmark<WriterPrefRWLock>},
+    {"PhaseFairRW",     0,              runBenchmark<PhaseFairRWLock>},
+    {"InstrumentedTTAS", 0,             runBenchmark<InstrumentedLock<TTASlock>>},
+    {"InstrumentedMCS", 0,              runBenchmark<InstrumentedLock<MCSLock>>},
+    {"std::mutex",      0,              runBenchmark<std::mutex>},
+    {"PetersonGood",    2,              runBenchmark<PetersonGood>},
+    {"Tournament",      TournamentLock::DEFAULT_CAPACITY, runBenchmark<TournamentLock>},
+};
+
+std::string getUsageString() {
+    std::string s = std::string("USAGE:\n") +
+                    "\t'./lock_bench [-t THREADS] [-c CS_WORK] [-n NCS_WORK] [-r READ_PCT] [-d MS] [-b MS] [-p 0|1] [-l LOCKS]'\n" +
+                    "\t - THREADS, CS_WORK, NCS_WORK, READ_PCT are comma-separated sweeps\n" +
+                    "\t   (default 1,2,4,8 / 0,100 / 0,100 / 0), e.g. '-r 90,99' for read-mostly mixes\n" +
+                    "\t - MS is the duration of each run in milliseconds (default 200)\n" +
+                    "\t - '-b MS' makes contention bursty: all threads run for the first half of\n" +
+                    "\t   every MS period, only one thread for the second half; mode_switches\n" +
+                    "\t   shows Adaptive moving to its queue in the bursts and back between them\n" +
+                    "\t - '-p 1' adds hardware counters (cycles, cache misses, ...) per run, or\n" +
+                    "\t   says 'perf disabled' where perf_event_open is not permitted\n" +
+                    "\t - LOCKS is a comma-separated subset of:";
+    for (const LockEntry& entry : LOCKS) {
+        s += std::string(" ") + entry.name;
+    }
+    return s + "\nWrites one CSV row per run to stdout.\n";
+}
+
+int main(int argc, char** argv) {
+    std::vector<unsigned> threads{1, 2, 4, 8};
+    std::vector<unsigned> csWork{0, 100};
+    std::vector<unsigned> ncsWork{0, 100};
+    std::vector<unsigned> readPercent{0};
+    std::vector<std::string> selected;
+    BenchConfig config;
+
+    if (argc % 2 == 0) {
+        std::cerr << getUsageString();
+        return -1;
+    }
+    for (int i = 1; i < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i+1];
+        if (flag == "-t") {
+            threads = parseThreadList(value);
+            if (threads.empty()) {
+                std::cerr << "THREADS must be at least 1\n" << getUsageString();
+                return -1;
+            }
+        } else if (flag == "-c") {
+            csWork = parseList(value);
+        } else if (flag == "-n") {
+            ncsWork = parseList(value);
+        } else if (flag == "-r") {
+            readPercent = parseList(value);
+        } else if (flag == "-d") {
+            config.duration = std::chrono::milliseconds{std::stoul(value)};
+        } else if (flag == "-b") {
+            config.burstPeriod = std::chrono::milliseconds{std::stoul(value)};
+        } else if (flag == "-p") {
+            config.perfCounters = std::stoul(value) != 0 && perfCountersAvailable();
+        } else if (flag == "-l") {
+            selected = parseNames(value);
+        } else {
+            std::cerr << getUsageString();
+            return -1;
+        }
+    }
+
+    bool allCorrect = true;
+    printCsvHeader(stdout, config);
+    for (const LockEntry& entry : LOCKS) {
+        if (!selected.empty() &&
+            std::find(selected.begin(), selected.end(), entry.name) == selected.end()) {
+            continue;
+        }
+        for (unsigned t : threads) {
+            if (entry.maxThreads && (int) t > entry.maxThreads) {
+                continue;
+            }
+            for (unsigned cs : csWork) {
+                for (unsigned ncs : ncsWork) {
+                    for (unsigned r : readPercent) {
+                        config.numThreads = t;
+                        config.csWork = cs;
+                        config.ncsWork = ncs;
+                        config.readPercent = r;
+                        BenchResult result = entry.run(entry.name, config);
+                        printCsvRow(stdout, result);
+                        if (!result.correct) {
+                            std::cerr << entry.name << ": mutual exclusion violated with "
+                                      << t << " threads" << std::endl;
+                            allCorrect = false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return allCorrect ? 0 : 1;
+}
@@ -0,0 +1,441 @@
+#ifndef LOCK_BENCHMARK_HPP
+#define LOCK_BENCHMARK_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>   // clock, process CPU time
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Concepts.hpp"
+#include "CacheLine.hpp"
+#include "Numa.hpp"
+#include "PerfCounters.hpp"
+
+/* One point of the sweep. Work is measured in iterations of busyWork(). */
+struct BenchConfig {
+    int numThreads{1};
+    unsigned csWork{0};   // work done while holding the lock
+    unsigned ncsWork{0};  // work done between releasing and re-acquiring
+    unsigned readPercent{0};  // share of acquisitions that only read, via lock_shared() if L has it
+    std::chrono::milliseconds duration{200};
+    // bursty contention: for the first half of every period all threads
+    // run, for the second half only thread 0 does (0 == always all threads)
+    std::chrono::milliseconds burstPeriod{0};
+    bool perfCounters{false};  // per-thread hardware counters around the measured loop
+    std::size_t maxSamples{1 << 16};  // per-thread latency buffer
+};
+
+struct BenchResult {
+    std::string lock;
+    BenchConfig config;
+    std::uint64_t acquisitions{0};
+    double seconds{0};
+    double cpuSeconds{0};  // CPU time of the whole process, exposes spinning vs parking
+    double throughput{0};  // acquisitions/sec
+    // handoff latency (ns): previous owner's release -> next waiter's acquire
+    std::uint64_t p50{0}, p99{0}, p999{0};
+    std::uint64_t minPerThread{0}, maxPerThread{0};
+    double fairness{0};  // Jain's index over per-thread acquisitions, 1 == perfectly fair
+    std::uint64_t reads{0};
+    // writes that ran on a different NUMA node than the previous one, i.e.
+    // the protected data had to cross nodes (always 0 on one-node machines)
+    std::uint64_t nodeSwitches{0};
+    // TTAS <-> queue mode changes of a lock that adapts (AdaptiveLock), else -1
+    std::int64_t modeSwitches{-1};
+    PerfCounts perf;  // whole run, summed over threads; UNAVAILABLE unless config.perfCounters
+    bool correct{false};  // counter matched the writes and no reader overlapped a writer
+};
+
+/* Locks that can describe themselves after a run, e.g. InstrumentedLock */
+template <typename T>
+concept ReportingLock = requires (const T t, std::FILE* out, const std::string& name) {
+    { t.report(out, name) };
+};
+
+/* Opaque to the optimizer, so the loop is not folded away. */
+inline void busyWork(unsigned iterations) {
+    for (unsigned i = 0; i < iterations; i++) {
+        asm volatile("" ::: "memory");
+    }
+}
+
+inline std::int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Per-thread xorshift, used to pick reads vs writes */
+inline std::uint32_t nextRandom(std::uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+inline std::uint64_t percentile(const std::vector<std::uint64_t>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    std::size_t idx = static_cast<std::size_t>(p * (sorted.size() - 1));
+    return sorted[idx];
+}
+
+/* Runs numThreads threads that repeatedly acquire 'L' for config.duration.
+ * With readPercent > 0 that share of the acquisitions are reads, taken with
+ * lock_shared() when L is a SharedLockConcept and with lock() otherwise, so
+ * exclusive locks give the baseline for the read-mostly mixes.
+ *
+ * Everything a thread records lives in its own buffer until the run is over;
+ * nothing is printed or allocated while the lock is held. */
+template <LockConcept L>
+BenchResult runBenchmark(const std::string& name, const BenchConfig& config) {
+    // protected by 'mutex', kept off the lock's own cache lines
+    struct alignas(CACHE_LINE_SIZE) Shared {
+        std::uint64_t counter{0};
+        bool writing{false};
+        std::int64_t releaseNs{0};
+        int lastOwner{-1};
+        unsigned lastNode{0};
+    };
+
+    struct alignas(CACHE_LINE_SIZE) PerThread {
+        std::uint64_t writes{0};
+        std::uint64_t reads{0};
+        std::uint64_t nodeSwitches{0};
+        bool sawWriter{false};
+        std::vector<std::uint64_t> handoffs;
+        PerfCounts perf;
+    };
+
+    std::unique_ptr<L> mutex = std::make_unique<L>();
+    std::unique_ptr<Shared> shared = std::make_unique<Shared>();
+    std::vector<PerThread> perThread(config.numThreads);
+    for (PerThread& t : perThread) {
+        t.handoffs.reserve(config.maxSamples);
+    }
+
+    const NumaTopology& topology = NumaTopology::get();
+    std::atomic_bool start{false};
+    std::atomic_bool stop{false};
+    std::int64_t startNs{0};  // published by 'start'
+    const std::int64_t burstNs = std::chrono::nanoseconds{config.burstPeriod}.count();
+
+    auto worker = [&](int id) {
+        PerThread& me = perThread[id];
+        std::uint32_t rng = 2654435761u * (id + 1);
+        std::optional<PerfCounters> perf;
+        if (config.perfCounters) {
+            perf.emplace();  // opened before the start line, counts this thread only
+        }
+        while (!start.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        if (perf) {
+            perf->start();
+        }
+
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (burstNs && id != 0) {
+                std::int64_t phase = (nowNs() - startNs) % burstNs;
+                if (phase >= burstNs / 2) {
+                    std::this_thread::sleep_for(std::chrono::nanoseconds{burstNs - phase});
+                    continue;
+                }
+            }
+            if (config.readPercent && nextRandom(rng) % 100 < config.readPercent) {
+                if constexpr (SharedLockConcept<L>) {
+                    mutex->lock_shared();
+                    me.sawWriter |= shared->writing;
+                    busyWork(config.csWork);
+                    me.sawWriter |= shared->writing;
+                    mutex->unlock_shared();
+                } else {
+                    mutex->lock();
+                    me.sawWriter |= shared->writing;
+                    busyWork(config.csWork);
+                    mutex->unlock();
+                }
+                me.reads++;
+                busyWork(config.ncsWork);
+                continue;
+            }
+
+            std::int64_t waitStart = nowNs();
+            mutex->lock();
+            std::int64_t acquired = nowNs();
+
+            // only count it as a handoff if we were already waiting when it was released
+            if (shared->lastOwner != id && shared->lastOwner != -1 &&
+                shared->releaseNs >= waitStart &&
+                me.handoffs.size() < config.maxSamples) {
+                me.handoffs.push_back(acquired - shared->releaseNs);
+            }
+            shared->writing = true;
+            shared->counter++;
+            if (topology.numNodes() > 1) {
+                unsigned node = topology.currentNode();
+                if (node != shared->lastNode) {
+                    me.nodeSwitches++;
+                    shared->lastNode = node;
+                }
+            }
+            busyWork(config.csWork);
+            shared->writing = false;
+            shared->lastOwner = id;
+            shared->releaseNs = nowNs();
+
+            mutex->unlock();
+            me.writes++;
+            busyWork(config.ncsWork);
+        }
+        if (perf) {
+            me.perf = perf->stop();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < config.numThreads; i++) {
+        threads.emplace_back(worker, i);
+    }
+
+    std::clock_t cpuBegin = std::clock();
+    auto begin = std::chrono::steady_clock::now();
+    startNs = nowNs();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(config.duration);
+    stop.store(true, std::memory_order_relaxed);
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::clock_t cpuEnd = std::clock();
+
+    if constexpr (ReportingLock<L>) {
+        mutex->report(stderr, name);
+    }
+
+    BenchResult result;
+    result.lock = name;
+    result.config = config;
+    result.seconds = std::chrono::duration<double>(end - begin).count();
+    result.cpuSeconds = static_cast<double>(cpuEnd - cpuBegin) / CLOCKS_PER_SEC;
+    if constexpr (requires { mutex->switches(); }) {
+        result.modeSwitches = mutex->switches();
+    }
+
+    std::vector<std::uint64_t> handoffs;
+    double sum = 0;
+    double sumSq = 0;
+    std::uint64_t writes = 0;
+    bool sawWriter = false;
+    result.minPerThread = perThread.front().writes + perThread.front().reads;
+    result.perf = perThread.front().perf;
+    for (const PerThread& t : perThread) {
+        std::uint64_t total = t.writes + t.reads;
+        writes += t.writes;
+        result.reads += t.reads;
+        result.nodeSwitches += t.nodeSwitches;
+        result.acquisitions += total;
+        result.minPerThread = std::min(result.minPerThread, total);
+        result.maxPerThread = std::max(result.maxPerThread, total);
+        sum += total;
+        sumSq += static_cast<double>(total) * total;
+        sawWriter |= t.sawWriter;
+        handoffs.insert(handoffs.end(), t.handoffs.begin(), t.handoffs.end());
+        if (&t != &perThread.front()) {
+            result.perf.merge(t.perf);
+        }
+    }
+    std::sort(handoffs.begin(), handoffs.end());
+
+    result.throughput = result.acquisitions / result.seconds;
+    result.p50 = percentile(handoffs, 0.50);
+    result.p99 = percentile(handoffs, 0.99);
+    result.p999 = percentile(handoffs, 0.999);
+    result.fairness = sumSq > 0 ? (sum * sum) / (config.numThreads * sumSq) : 1.0;
+    result.correct = shared->counter == writes && !sawWriter;
+    return result;
+}
+
+/* Result of runWorkload(), for benchmarks of whole operations rather than
+ * bare lock acquisitions. */
+struct WorkloadResult {
+    std::uint64_t ops{0};
+    double seconds{0};
+    PerfCounts perf;  // summed over threads; UNAVAILABLE unless config.perfCounters
+    bool correct{false};
+};
+
+/* Runs op(rng) on every thread for config.duration. op returns the net
+ * change in the structure's size (+1 added, -1 removed, 0 otherwise). */
+template <typename Op>
+WorkloadResult runWorkload(const BenchConfig& config, Op op, std::int64_t& netChange) {
+    struct alignas(CACHE_LINE_SIZE) PerThread {
+        std::uint64_t ops{0};
+        std::int64_t net{0};
+        PerfCounts perf;
+    };
+    std::vector<PerThread> perThread(config.numThreads);
+    std::atomic_bool start{false};
+    std::atomic_bool stop{false};
+
+    std::vector<std::thread> threads;
+    for (int id = 0; id < config.numThreads; id++) {
+        threads.emplace_back([&, id]() {
+            PerThread& me = perThread[id];
+            std::uint32_t rng = 2654435761u * (id + 1);
+            std::optional<PerfCounters> perf;
+            if (config.perfCounters) {
+                perf.emplace();
+            }
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            if (perf) {
+                perf->start();
+            }
+            while (!stop.load(std::memory_order_relaxed)) {
+                me.net += op(rng);
+                me.ops++;
+                busyWork(config.ncsWork);
+            }
+            if (perf) {
+                me.perf = perf->stop();
+            }
+        });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(config.duration);
+    stop.store(true, std::memory_order_relaxed);
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    WorkloadResult result;
+    result.seconds = std::chrono::duration<double>(end - begin).count();
+    netChange = 0;
+    result.perf = perThread.front().perf;
+    for (const PerThread& t : perThread) {
+        result.ops += t.ops;
+        netChange += t.net;
+        if (&t != &perThread.front()) {
+            result.perf.merge(t.perf);
+        }
+    }
+    return result;
+}
+
+/* For '-p 1': true if this machine lets us read at least one counter, else
+ * says so once on stderr, and the driver leaves the counter columns out */
+inline bool perfCountersAvailable() {
+    if (PerfCounters{}.available()) {
+        return true;
+    }
+    std::fprintf(stderr, "perf disabled, timing only\n");
+    return false;
+}
+
+/* The counter columns, for drivers that print them when config.perfCounters */
+inline void printPerfHeader(std::FILE* out) {
+    for (const char* event : PerfCounts::NAMES) {
+        std::fprintf(out, "%s,", event);
+    }
+}
+
+/* Left empty for an event that could not be opened */
+inline void printPerfFields(std::FILE* out, const PerfCounts& perf) {
+    for (std::int64_t value : perf.values) {
+        if (value == PerfCounts::UNAVAILABLE) {
+            std::fprintf(out, ",");
+        } else {
+            std::fprintf(out, "%lld,", (long long) value);
+        }
+    }
+}
+
+/* The counter columns are there only if config.perfCounters */
+inline void printCsvHeader(std::FILE* out, const BenchConfig& config) {
+    std::fprintf(out, "lock,threads,cs_work,ncs_work,read_pct,burst_ms,acquisitions,reads,seconds,cpu_seconds,"
+                      "throughput,p50_ns,p99_ns,p999_ns,"
+                      "min_per_thread,max_per_thread,fairness,node_switches,mode_switches,");
+    if (config.perfCounters) {
+        printPerfHeader(out);
+    }
+    std::fprintf(out, "correct\n");
+}
+
+inline void printCsvRow(std::FILE* out, const BenchResult& r) {
+    std::fprintf(out, "%s,%d,%u,%u,%u,%lld,%llu,%llu,%.4f,%.4f,%.0f,%llu,%llu,%llu,%llu,%llu,%.4f,%llu,",
+                 r.lock.c_str(),
+                 r.config.numThreads,
+                 r.config.csWork,
+                 r.config.ncsWork,
+                 r.config.readPercent,
+                 (long long) r.config.burstPeriod.count(),
+                 (unsigned long long) r.acquisitions,
+                 (unsigned long long) r.reads,
+                 r.seconds,
+                 r.cpuSeconds,
+                 r.throughput,
+                 (unsigned long long) r.p50,
+                 (unsigned long long) r.p99,
+                 (unsigned long long) r.p999,
+                 (unsigned long long) r.minPerThread,
+                 (unsigned long long) r.maxPerThread,
+                 r.fairness,
+                 (unsigned long long) r.nodeSwitches);
+    // left empty for locks without modes
+    if (r.modeSwitches >= 0) {
+        std::fprintf(out, "%lld,", (long long) r.modeSwitches);
+    } else {
+        std::fprintf(out, ",");
+    }
+    if (r.config.perfCounters) {
+        printPerfFields(out, r.perf);
+    }
+    std::fprintf(out, "%d\n", r.correct ? 1 : 0);
+    std::fflush(out);
+}
+
+/* "1,2,4" -> {1, 2, 4}, for the sweep arguments of the drivers */
+inline std::vector<unsigned> parseList(const char* arg) {
+    std::vector<unsigned> values;
+    std::stringstream ss{arg};
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        values.push_back(std::stoul(item));
+    }
+    return values;
+}
+
+/* parseList for thread counts: empty if the list is, or if any count is
+ * below 1, so that the driver can print its usage instead of running */
+inline std::vector<unsigned> parseThreadList(const char* arg) {
+    std::vector<unsigned> values = parseList(arg);
+    if (std::find(values.begin(), values.end(), 0u) != values.end()) {
+        values.clear();
+    }
+    return values;
+}
+
+inline std::vector<std::string> parseNames(const char* arg) {
+    std::vector<std::string> names;
+    std::stringstream ss{arg};
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        names.push_back(item);
+    }
+    return names;
+}
+
+#endif
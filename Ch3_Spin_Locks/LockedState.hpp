@@ -0,0 +1,31 @@
+#ifndef LOCKED_STATE_HPP
+#define LOCKED_STATE_HPP
+
+#include <mutex>    // lock_guard
+#include <utility>  // forward
+#include "Concepts.hpp"
+
+/* A State guarded by any LockConcept type, behind the same apply(f)
+ * interface as FlatCombiner and Delegator, so a benchmark written against
+ * ExecutorConcept can swap a plain lock for either of them:
+ *
+ *     LockedState<TTASlock, std::uint64_t> counter;
+ *     counter.apply([](std::uint64_t& c) { c++; }); */
+template <LockConcept L, typename State>
+class LockedState {
+public:
+    template <typename... Args>
+    explicit LockedState(Args&&... args) : state(std::forward<Args>(args)...) {}
+
+    template <typename F>
+    auto apply(F&& f) {
+        std::lock_guard<L> guard{mutex};
+        return f(state);
+    }
+
+private:
+    L mutex;
+    State state;
+};
+
+#endif
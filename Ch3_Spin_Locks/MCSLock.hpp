@@ -0,0 +1,96 @@
+#ifndef MCS_LOCK_HPP
+#define MCS_LOCK_HPP
+
+#include <atomic>
+#include "Backoff.hpp"    // cpuRelax
+#include "CacheLine.hpp"
+#include "Concepts.hpp"
+#include "NodeCache.hpp"
+
+/* MCS queue lock. Like CLHLock the waiters form a FIFO queue, but the list
+ * is explicit: each waiter spins on the 'locked' flag of its OWN node, and
+ * the releasing thread hands the lock over by writing directly into its
+ * successor's node. A waiter therefore only ever spins on a line it owns,
+ * which matters when the predecessor runs on another socket.
+ *
+ * Two ways to use it:
+ *   - lock(node)/unlock(node): caller supplies the node (e.g. on its stack,
+ *     see MCSLock::Guard). The node must stay alive until unlock returns.
+ *   - lock()/unlock(): LockConcept-compatible, takes the node from a
+ *     thread-local cache. */
+class MCSLock {
+public:
+    struct alignas(CACHE_LINE_SIZE) QNode {
+        std::atomic<QNode*> next{nullptr};
+        std::atomic_bool locked{false};
+        QNode* nextFree{nullptr};  // only used by NodeCache
+    };
+
+    /* Scoped guard, keeps its node on the caller's stack */
+    class Guard {
+    public:
+        explicit Guard(MCSLock& mutex) : mutex{mutex} {
+            mutex.lock(node);
+        }
+
+        ~Guard() {
+            mutex.unlock(node);
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+    private:
+        MCSLock& mutex;
+        QNode node;
+    };
+
+    void lock(QNode& node) {
+        node.next.store(nullptr, std::memory_order_relaxed);
+        node.locked.store(true, std::memory_order_relaxed);
+        QNode* pred = tail.exchange(&node, std::memory_order_acq_rel);
+        if (pred) {
+            // release: our initialized node is visible before pred can write to it
+            pred->next.store(&node, std::memory_order_release);
+            while (node.locked.load(std::memory_order_acquire)) {
+                cpuRelax();
+            }
+        }
+    }
+
+    void unlock(QNode& node) {
+        QNode* succ = node.next.load(std::memory_order_acquire);
+        if (!succ) {
+            QNode* expected = &node;
+            if (tail.compare_exchange_strong(expected, nullptr,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+                return;  // no one was waiting
+            }
+            // a successor swapped itself into tail but has not linked in yet
+            while (!(succ = node.next.load(std::memory_order_acquire))) {
+                cpuRelax();
+            }
+        }
+        succ->locked.store(false, std::memory_order_release);
+    }
+
+    void lock() {
+        QNode* node = NodeCache<QNode>::local().get();
+        lock(*node);
+        holder = node;
+    }
+
+    void unlock() {
+        QNode* node = holder;
+        unlock(*node);
+        NodeCache<QNode>::local().put(node);
+    }
+
+private:
+    alignas(CACHE_LINE_SIZE) std::atomic<QNode*> tail{nullptr};
+    QNode* holder{nullptr};  // only read/written by the thread holding the lock
+};
+static_assert(LockConcept<MCSLock>);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef NODE_CACHE_HPP
+#define NODE_CACHE_HPP
+
+/* Per-thread free list of queue-lock nodes. 'Node' must have a
+ * 'Node* nextFree' member. Usually holds a single node; a thread holding k
+ * queue locks at once has k nodes in flight. Nodes left in the cache are
+ * freed when the thread exits. */
+template <typename Node>
+class NodeCache {
+public:
+    static NodeCache& local() {
+        thread_local NodeCache cache;
+        return cache;
+    }
+
+    ~NodeCache() {
+        while (head) {
+            Node* next = head->nextFree;
+            delete head;
+            head = next;
+        }
+    }
+
+    Node* get() {
+        if (!head) {
+            return new Node{};
+        }
+        Node* node = head;
+        head = node->nextFree;
+        return node;
+    }
+
+    void put(Node* node) {
+        node->nextFree = head;
+        head = node;
+    }
+
+private:
+    NodeCache() = default;
+
+    Node* head{nullptr};
+};
+
+#endif
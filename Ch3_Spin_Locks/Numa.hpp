@@ -0,0 +1,93 @@
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sched.h>  // sched_getcpu
+
+/* CPU -> NUMA node map read once from /sys/devices/system/node. On machines
+ * without that directory (or with a single node) everything maps to node 0. */
+class NumaTopology {
+public:
+    static const NumaTopology& get() {
+        static const NumaTopology topology;
+        return topology;
+    }
+
+    unsigned numNodes() const {
+        return nodes;
+    }
+
+    unsigned nodeOf(int cpu) const {
+        if (cpu < 0 || (std::size_t) cpu >= cpuToNode.size()) {
+            return 0;
+        }
+        return cpuToNode[cpu];
+    }
+
+    /* Node of the CPU the calling thread is running on right now. It may be
+     * stale by the time the caller uses it; that only costs locality. */
+    unsigned currentNode() const {
+        if (nodes == 1) {
+            return 0;
+        }
+        return nodeOf(sched_getcpu());
+    }
+
+private:
+    NumaTopology() {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        fs::directory_iterator it{"/sys/devices/system/node", ec};
+        if (!ec) {
+            for (const fs::directory_entry& entry : it) {
+                std::string name = entry.path().filename().string();
+                if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+                    name.find_first_not_of("0123456789", 4) != std::string::npos) {
+                    continue;
+                }
+                unsigned node = std::stoul(name.substr(4));
+                std::ifstream cpulist{entry.path() / "cpulist"};
+                std::string list;
+                if (!std::getline(cpulist, list)) {
+                    continue;
+                }
+                for (int cpu : parseCpuList(list)) {
+                    if ((std::size_t) cpu >= cpuToNode.size()) {
+                        cpuToNode.resize(cpu + 1, 0);
+                    }
+                    cpuToNode[cpu] = node;
+                }
+                nodes = std::max(nodes, node + 1);
+            }
+        }
+    }
+
+    /* "0-3,8-11" -> {0, 1, 2, 3, 8, 9, 10, 11} */
+    static std::vector<int> parseCpuList(const std::string& list) {
+        std::vector<int> cpus;
+        std::stringstream ss{list};
+        std::string range;
+        while (std::getline(ss, range, ',')) {
+            if (range.empty()) {
+                continue;
+            }
+            std::size_t dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; cpu++) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    unsigned nodes{1};
+    std::vector<unsigned> cpuToNode;
+};
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstring>  // memset
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* Hardware counters of one thread over a measured region, read through
+ * perf_event_open. Every event is opened on its own, so a CPU or VM that
+ * lacks one (or a kernel that refuses all of them, perf_event_paranoid > 2,
+ * containers without CAP_PERFMON) just reports that event as UNAVAILABLE and
+ * the benchmark falls back to its timings.
+ *
+ *     PerfCounters perf;  // on the thread to be measured
+ *     perf.start();
+ *     ...
+ *     PerfCounts counts = perf.stop();
+ *
+ * HITM (loads that hit a line Modified in another core's cache, i.e. true
+ * or false sharing) has no generic perf event; it is only opened on Intel,
+ * with the MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM encoding of Skylake and later. */
+struct PerfCounts {
+    enum Event { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, HITM, NUM_EVENTS };
+    static constexpr const char* NAMES[NUM_EVENTS] = {
+        "cycles", "instructions", "l1d_misses", "llc_misses", "hitm"};
+    static constexpr std::int64_t UNAVAILABLE = -1;
+
+    std::array<std::int64_t, NUM_EVENTS> values;
+
+    PerfCounts() {
+        values.fill(UNAVAILABLE);
+    }
+
+    /* Sums per-thread counts; an event missing on any thread is missing */
+    void merge(const PerfCounts& other) {
+        for (int i = 0; i < NUM_EVENTS; i++) {
+            if (values[i] == UNAVAILABLE || other.values[i] == UNAVAILABLE) {
+                values[i] = UNAVAILABLE;
+            } else {
+                values[i] += other.values[i];
+            }
+        }
+    }
+};
+
+class PerfCounters {
+public:
+    /* Opens the counters for the calling thread, user space only */
+    PerfCounters() {
+        constexpr std::uint64_t CACHE_READ_MISS =
+            (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        fds[PerfCounts::CYCLES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds[PerfCounts::INSTRUCTIONS] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fds[PerfCounts::L1D_MISSES] = openEvent(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | CACHE_READ_MISS);
+        fds[PerfCounts::LLC_MISSES] = openEvent(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | CACHE_READ_MISS);
+        fds[PerfCounts::HITM] = -1;
+#if defined(__x86_64__) || defined(__i386__)
+        if (__builtin_cpu_is("intel")) {
+            fds[PerfCounts::HITM] = openEvent(PERF_TYPE_RAW, 0x04d2);  // umask 0x04, event 0xd2
+        }
+#endif
+    }
+
+    ~PerfCounters() {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /* True if at least one event could be opened */
+    bool available() const {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void start() {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+
+    PerfCounts stop() {
+        PerfCounts counts;
+        for (int i = 0; i < PerfCounts::NUM_EVENTS; i++) {
+            if (fds[i] >= 0) {
+                ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+        for (int i = 0; i < PerfCounts::NUM_EVENTS; i++) {
+            counts.values[i] = readEvent(fds[i]);
+        }
+        return counts;
+    }
+
+private:
+    static int openEvent(std::uint32_t type, std::uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    /* Scaled up if the kernel had to multiplex the counter */
+    static std::int64_t readEvent(int fd) {
+        if (fd < 0) {
+            return PerfCounts::UNAVAILABLE;
+        }
+        std::uint64_t buf[3];  // value, time enabled, time running
+        if (::read(fd, buf, sizeof(buf)) != sizeof(buf) || buf[2] == 0) {
+            return PerfCounts::UNAVAILABLE;
+        }
+        double scale = buf[2] < buf[1] ? static_cast<double>(buf[1]) / buf[2] : 1.0;
+        return static_cast<std::int64_t>(buf[0] * scale);
+    }
+
+    std::array<int, PerfCounts::NUM_EVENTS> fds;
+};
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef RW_LOCK_HPP
+#define RW_LOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include "Backoff.hpp"    // cpuRelax
+#include "CacheLine.hpp"
+#include "Concepts.hpp"
+
+/* Reader-writer spin locks: lock()/unlock() for writers,
+ * lock_shared()/unlock_shared() for readers, same names as
+ * std::shared_mutex so they also work with std::shared_lock. */
+
+/* One word: the top bit is the writer, the rest counts readers. Readers get
+ * in whenever no writer holds the lock, so a steady stream of readers
+ * starves writers. */
+class TTASRWLock {
+public:
+    void lock() {
+        while (true) {
+            while (state.load(std::memory_order_relaxed) != 0) {
+                cpuRelax();
+            }
+            std::uint32_t expected = 0;
+            if (state.compare_exchange_weak(expected, WRITER,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+                return;
+            }
+        }
+    }
+
+    void unlock() {
+        state.fetch_and(~WRITER, std::memory_order_release);
+    }
+
+    void lock_shared() {
+        while (true) {
+            std::uint32_t current = state.load(std::memory_order_relaxed);
+            if (current & WRITER) {
+                cpuRelax();
+                continue;
+            }
+            if (state.compare_exchange_weak(current, current + 1,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+                return;
+            }
+        }
+    }
+
+    void unlock_shared() {
+        state.fetch_sub(1, std::memory_order_release);
+    }
+
+private:
+    static constexpr std::uint32_t WRITER = 1u << 31;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> state{0};
+};
+static_assert(SharedLockConcept<TTASRWLock>);
+
+/* Like TTASRWLock, but a writer announces itself before it waits, and new
+ * readers hold off while any writer is waiting. Writers can no longer be
+ * starved; readers can, if writers keep arriving.
+ *
+ * Layout: | WRITER (1) | waiting writers (15) | readers (16) | */
+class WriterPrefRWLock {
+public:
+    void lock() {
+        state.fetch_add(WAITING_WRITER, std::memory_order_relaxed);
+        while (true) {
+            std::uint32_t current = state.load(std::memory_order_relaxed);
+            if ((current & (WRITER | READER_MASK)) != 0) {
+                cpuRelax();
+                continue;
+            }
+            // take the lock and withdraw our announcement in one step
+            if (state.compare_exchange_weak(current, current - WAITING_WRITER + WRITER,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+                return;
+            }
+        }
+    }
+
+    void unlock() {
+        state.fetch_sub(WRITER, std::memory_order_release);
+    }
+
+    void lock_shared() {
+        while (true) {
+            std::uint32_t current = state.load(std::memory_order_relaxed);
+            if ((current & ~READER_MASK) != 0) {  // writer active or waiting
+                cpuRelax();
+                continue;
+            }
+            if (state.compare_exchange_weak(current, current + 1,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+                return;
+            }
+        }
+    }
+
+    void unlock_shared() {
+        state.fetch_sub(1, std::memory_order_release);
+    }
+
+private:
+    static constexpr std::uint32_t READER_MASK = 0xffff;
+    static constexpr std::uint32_t WAITING_WRITER = 1u << 16;
+    static constexpr std::uint32_t WRITER = 1u << 31;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> state{0};
+};
+static_assert(SharedLockConcept<WriterPrefRWLock>);
+
+/* Phase-fair ticket RW lock (Brandenburg & Anderson, PF-T). Reader and
+ * writer phases alternate: a reader arriving while a writer is present or
+ * waiting waits for at most one writer phase, and a writer waits for at most
+ * one reader phase (plus the writers ahead of it in ticket order), so
+ * neither side starves.
+ *
+ * rin/rout count reader arrivals/departures in units of READER_INC. A writer
+ * sets PRESENT (and its phase bit) in the low bits of rin, which blocks new
+ * readers, and waits for rout to catch up with the readers that got in
+ * before it. Writers among themselves are a plain ticket lock. */
+class PhaseFairRWLock {
+public:
+    void lock() {
+        std::uint32_t ticket = writerIn.fetch_add(1, std::memory_order_relaxed);
+        while (writerOut.load(std::memory_order_acquire) != ticket) {
+            cpuRelax();
+        }
+        std::uint32_t bits = PRESENT | (ticket & PHASE_ID);
+        std::uint32_t readersAhead = readerIn.fetch_add(bits, std::memory_order_acq_rel);
+        while (readerOut.load(std::memory_order_acquire) != readersAhead) {
+            cpuRelax();
+        }
+    }
+
+    void unlock() {
+        readerIn.fetch_and(~WRITER_BITS, std::memory_order_release);
+        writerOut.fetch_add(1, std::memory_order_release);
+    }
+
+    void lock_shared() {
+        std::uint32_t writer = readerIn.fetch_add(READER_INC, std::memory_order_acquire) & WRITER_BITS;
+        if (writer != 0) {
+            // wait for this writer phase to end, i.e. the bits to change
+            while ((readerIn.load(std::memory_order_acquire) & WRITER_BITS) == writer) {
+                cpuRelax();
+            }
+        }
+    }
+
+    void unlock_shared() {
+        readerOut.fetch_add(READER_INC, std::memory_order_release);
+    }
+
+private:
+    static constexpr std::uint32_t READER_INC = 0x100;
+    static constexpr std::uint32_t WRITER_BITS = 0x3;
+    static constexpr std::uint32_t PRESENT = 0x2;
+    static constexpr std::uint32_t PHASE_ID = 0x1;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> readerIn{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> readerOut{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> writerIn{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> writerOut{0};
+};
+static_assert(SharedLockConcept<PhaseFairRWLock>);
+
+#endif
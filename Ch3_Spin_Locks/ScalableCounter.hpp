@@ -0,0 +1,159 @@
+#ifndef SCALABLE_COUNTER_HPP
+#define SCALABLE_COUNTER_HPP
+
+#include <atomic>
+#include <bit>      // bit_ceil
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>   // unique_ptr
+#include "CacheLine.hpp"
+#include "ThreadIndex.hpp"
+#include "TscClock.hpp"
+
+/* Striped counter: one cache-line-padded cell per thread (by ThreadIndex),
+ * so add() is a fetch_add on a line no other thread writes, and read() sums
+ * the cells. add() is wait-free; read() is not a snapshot, but it is exact
+ * once the writers are quiescent and never misses an add() that completed
+ * before it started.
+ *
+ * The cell count is rounded up to a power of two; threads beyond it share
+ * cells (by mask), which only costs contention, never counts. */
+class ScalableCounter {
+public:
+    static constexpr std::size_t DEFAULT_CELLS = 64;
+
+    explicit ScalableCounter(std::size_t cells = DEFAULT_CELLS)
+    : mask{std::bit_ceil(cells) - 1},
+      cells{std::make_unique<Cell[]>(mask + 1)} {}
+
+    void add(std::int64_t delta) {
+        cells[ThreadIndex::get() & mask].value.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    void increment() {
+        add(1);
+    }
+
+    std::int64_t read() const {
+        std::int64_t sum = 0;
+        for (std::size_t i = 0; i <= mask; i++) {
+            sum += cells[i].value.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Cell {
+        std::atomic<std::int64_t> value{0};
+    };
+
+    const std::size_t mask;
+    std::unique_ptr<Cell[]> cells;
+};
+
+/* ScalableCounter plus a cached total for hot readers. readApprox() returns
+ * the cached sum while it is younger than maxAge; once it is stale one reader
+ * re-sums the cells while the others keep returning the old value, so
+ * readers never queue up behind a scan. read() is still the exact sum. */
+class ApproximateCounter {
+public:
+    explicit ApproximateCounter(std::chrono::nanoseconds maxAge = std::chrono::microseconds{100},
+                                std::size_t cells = ScalableCounter::DEFAULT_CELLS)
+    : counter{cells},
+      maxAgeTicks{static_cast<std::uint64_t>(maxAge.count() / TscClock::nanosPerTick())} {}
+
+    void add(std::int64_t delta) {
+        counter.add(delta);
+    }
+
+    void increment() {
+        counter.add(1);
+    }
+
+    std::int64_t read() const {
+        return counter.read();
+    }
+
+    std::int64_t readApprox() {
+        std::uint64_t now = TscClock::now();
+        if (now - cachedAt.load(std::memory_order_relaxed) > maxAgeTicks &&
+            !refreshing.load(std::memory_order_relaxed) &&
+            !refreshing.exchange(true, std::memory_order_acquire)) {
+            cached.store(counter.read(), std::memory_order_relaxed);
+            cachedAt.store(TscClock::now(), std::memory_order_relaxed);
+            refreshing.store(false, std::memory_order_release);
+        }
+        return cached.load(std::memory_order_relaxed);
+    }
+
+private:
+    ScalableCounter counter;
+    const std::uint64_t maxAgeTicks;
+    // read-mostly, kept away from the cells and from each other's writers
+    alignas(CACHE_LINE_SIZE) std::atomic<std::int64_t> cached{0};
+    std::atomic<std::uint64_t> cachedAt{0};
+    alignas(CACHE_LINE_SIZE) std::atomic_bool refreshing{false};
+};
+
+/* Scalable non-zero indicator (Ellen, Lev, Luchangco & Moir), flattened to
+ * two levels. Answers "is anyone inside?" without keeping an exact count in
+ * one word: threads arrive/depart on their own leaf, and only a leaf's
+ * 0 -> 1 and 1 -> 0 transitions touch the shared root, so query() reads a
+ * line that changes rarely instead of one every arrival writes.
+ *
+ * A thread must depart() on the same thread that arrive()d, since both pick
+ * the leaf by ThreadIndex. arrive() bumps the root before publishing the
+ * leaf's 0 -> 1, so query() may briefly report true for an arrive() that is
+ * still retrying, but never false while anyone has arrived. */
+class SNZI {
+public:
+    explicit SNZI(std::size_t leaves = ScalableCounter::DEFAULT_CELLS)
+    : mask{std::bit_ceil(leaves) - 1},
+      leaves{std::make_unique<Leaf[]>(mask + 1)} {}
+
+    void arrive() {
+        std::atomic<std::uint32_t>& leaf = leaves[ThreadIndex::get() & mask].count;
+        std::uint32_t current = leaf.load(std::memory_order_relaxed);
+        while (true) {
+            if (current > 0) {
+                if (leaf.compare_exchange_weak(current, current + 1,
+                                               std::memory_order_acquire,
+                                               std::memory_order_relaxed)) {
+                    return;
+                }
+                continue;
+            }
+            root.fetch_add(1, std::memory_order_acq_rel);
+            if (leaf.compare_exchange_strong(current, 1,
+                                             std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+                return;
+            }
+            // someone else opened the leaf first; 'current' now holds its count
+            root.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    void depart() {
+        std::atomic<std::uint32_t>& leaf = leaves[ThreadIndex::get() & mask].count;
+        if (leaf.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            root.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    bool query() const {
+        return root.load(std::memory_order_acquire) != 0;
+    }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Leaf {
+        std::atomic<std::uint32_t> count{0};
+    };
+
+    const std::size_t mask;
+    std::unique_ptr<Leaf[]> leaves;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> root{0};
+};
+
+#endif
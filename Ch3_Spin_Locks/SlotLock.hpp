@@ -0,0 +1,37 @@
+#ifndef SLOT_LOCK_HPP
+#define SLOT_LOCK_HPP
+
+#include <utility>  // declval, forward
+#include "Concepts.hpp"
+
+/* Adapts an array lock, whose lock() returns the slot that must be passed
+ * back to unlock(slot), to LockConcept (and so to std::lock_guard and
+ * std::unique_lock):
+ *
+ *     SlotLock<CacheAwareALock> mutex{128};
+ *     std::unique_lock<SlotLock<CacheAwareALock>> guard{mutex};
+ *
+ * The slot is only ever touched by the thread holding the lock, so the
+ * lock's own handoff orders it. */
+template <typename L>
+class SlotLock {
+public:
+    using Slot = decltype(std::declval<L&>().lock());
+
+    template <typename... Args>
+    explicit SlotLock(Args&&... args) : mutex(std::forward<Args>(args)...) {}
+
+    void lock() {
+        slot = mutex.lock();
+    }
+
+    void unlock() {
+        mutex.unlock(slot);
+    }
+
+private:
+    L mutex;
+    Slot slot{};
+};
+
+#endif
@@ -1,4 +1,8 @@
+#ifndef TAS_LOCK_HPP
+#define TAS_LOCK_HPP
+
 #include <atomic>
+#include "Backoff.hpp"
 
 class TASlock
 {
@@ -34,3 +38,43 @@ public:
 private:
     std::atomic_bool flag{false};
 };
+
+/* TTASlock that, after losing the race for the flag, backs off for a random
+ * and exponentially growing delay instead of immediately spinning again, so
+ * the waiters do not all retry the exchange the moment the flag drops.
+ *
+ * The delay bounds default to the template arguments and can be overridden
+ * per instance. */
+template <unsigned MinDelay = 16, unsigned MaxDelay = 4096>
+class BackoffLock
+{
+public:
+    BackoffLock() = default;
+
+    BackoffLock(unsigned minDelay, unsigned maxDelay)
+    : minDelay{minDelay}, maxDelay{maxDelay} {}
+
+    void lock() {
+        Backoff backoff{minDelay, maxDelay};
+        while (true) {
+            while (flag.load(std::memory_order_relaxed)) {
+                cpuRelax();
+            }
+            if (!flag.exchange(true, std::memory_order_acquire)) {
+                return;
+            }
+            backoff.backoff();
+        }
+    }
+
+    void unlock() {
+        flag.store(false, std::memory_order_release);
+    }
+
+private:
+    std::atomic_bool flag{false};
+    unsigned minDelay{MinDelay};
+    unsigned maxDelay{MaxDelay};
+};
+
+#endif
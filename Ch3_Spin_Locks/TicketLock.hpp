@@ -0,0 +1,86 @@
+#ifndef TICKET_LOCK_HPP
+#define TICKET_LOCK_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include "Backoff.hpp"    // cpuRelax, readCycles
+#include "CacheLine.hpp"
+#include "Concepts.hpp"
+
+/* Ticket lock with proportional backoff. lock() draws a ticket and waits
+ * until nowServing reaches it, so the lock is granted FIFO using only two
+ * counters (each on its own cache line).
+ *
+ * A waiter with k tickets ahead of it knows the lock will not be its turn
+ * for roughly k hold times, so instead of hammering nowServing it waits
+ * (k-1) average hold times before looking again, and only the next in line
+ * polls continuously. The average is kept by the holders themselves, and
+ * only for acquisitions that had to wait, so the uncontended path never
+ * reads the clock. */
+class TicketLock {
+public:
+    // bounds a single backoff, e.g. after a holder was descheduled
+    static constexpr std::uint64_t MAX_WAIT = 1 << 20;
+
+    void lock() {
+        std::uint32_t ticket = nextTicket.fetch_add(1, std::memory_order_relaxed);
+        std::uint32_t serving = nowServing.load(std::memory_order_acquire);
+        if (serving == ticket) {
+            return;
+        }
+
+        while (serving != ticket) {
+            std::uint32_t ahead = ticket - serving;
+            if (ahead > 1) {
+                std::uint64_t start = readCycles();
+                std::uint64_t wait = std::min(MAX_WAIT,
+                                              (ahead - 1) * holdEstimate.load(std::memory_order_relaxed));
+                while (readCycles() - start < wait) {
+                    cpuRelax();
+                }
+            } else {
+                cpuRelax();
+            }
+            serving = nowServing.load(std::memory_order_acquire);
+        }
+        holdStart = readCycles();
+    }
+
+    /* Takes the lock only if no one holds it or is queued for it. */
+    bool try_lock() {
+        std::uint32_t serving = nowServing.load(std::memory_order_relaxed);
+        std::uint32_t expected = serving;
+        return nextTicket.compare_exchange_strong(expected, serving + 1,
+                                                  std::memory_order_acquire,
+                                                  std::memory_order_relaxed);
+    }
+
+    /* Called by the holder: true if another thread is queued behind it. */
+    bool hasWaiters() const {
+        return nextTicket.load(std::memory_order_relaxed) -
+               nowServing.load(std::memory_order_relaxed) > 1;
+    }
+
+    void unlock() {
+        if (holdStart) {
+            std::uint64_t estimate = holdEstimate.load(std::memory_order_relaxed);
+            std::int64_t delta = (std::int64_t) (readCycles() - holdStart) - (std::int64_t) estimate;
+            holdEstimate.store(estimate + delta / 8, std::memory_order_relaxed);
+            holdStart = 0;
+        }
+        // only the holder writes nowServing
+        std::uint32_t next = nowServing.load(std::memory_order_relaxed) + 1;
+        nowServing.store(next, std::memory_order_release);
+    }
+
+private:
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> nextTicket{0};
+    // written by the holder only, read by the waiters polling nowServing anyway
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> nowServing{0};
+    std::atomic<std::uint64_t> holdEstimate{0};  // running average hold time, readCycles() units
+    std::uint64_t holdStart{0};  // set when the current holder had to wait
+};
+static_assert(LockConcept<TicketLock>);
+
+#endif
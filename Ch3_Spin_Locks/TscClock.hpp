@@ -0,0 +1,40 @@
+#ifndef TSC_CLOCK_HPP
+#define TSC_CLOCK_HPP
+
+#include <chrono>
+#include <cstdint>
+#include "Backoff.hpp"  // readCycles
+
+/* Timestamps in readCycles() ticks (the TSC on x86), converted to
+ * nanoseconds with a ratio measured against steady_clock. Calibration runs
+ * once, the first time a conversion is needed, so code that only records
+ * raw ticks never pays for it. Assumes an invariant TSC, as on any x86 CPU
+ * of the last decade. */
+class TscClock {
+public:
+    static std::uint64_t now() {
+        return readCycles();
+    }
+
+    static double nanosPerTick() {
+        static const double ratio = calibrate();
+        return ratio;
+    }
+
+    static double toNanos(std::uint64_t ticks) {
+        return ticks * nanosPerTick();
+    }
+
+private:
+    static double calibrate() {
+        using namespace std::chrono;
+        auto wallStart = steady_clock::now();
+        std::uint64_t tickStart = readCycles();
+        while (steady_clock::now() - wallStart < milliseconds{10}) {}
+        std::uint64_t ticks = readCycles() - tickStart;
+        double nanos = duration<double, std::nano>(steady_clock::now() - wallStart).count();
+        return ticks ? nanos / ticks : 1.0;
+    }
+};
+
+#endif
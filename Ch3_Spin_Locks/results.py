@@ -1,8 +1,19 @@
 import pandas as pd
 import sys
 
+# Summarizes the CSV written by ./lock_bench. Given a second CSV (e.g. from
+# a previous build), prints the relative throughput change per configuration.
+KEY = ["lock", "threads", "cs_work", "ncs_work", "read_pct", "burst_ms"]
+
 if __name__ == "__main__":
     df = pd.read_csv(sys.argv[1])
-    s = sys.argv[1] + ": " + str(df['time'].mean())
-    print(s)
+    print(df.pivot_table(index=["lock", "cs_work", "ncs_work", "read_pct", "burst_ms"],
+                         columns="threads",
+                         values="throughput").to_string())
 
+    if len(sys.argv) > 2:
+        base = pd.read_csv(sys.argv[2])
+        merged = df.merge(base, on=KEY, suffixes=("", "_base"))
+        merged["throughput_change"] = merged["throughput"] / merged["throughput_base"] - 1
+        merged["p99_change"] = merged["p99_ns"] / merged["p99_ns_base"].replace(0, float("nan")) - 1
+        print(merged[KEY + ["throughput_change", "p99_change"]].to_string(index=False))
@@ -24,10 +24,10 @@ enum ModificationType {
 template <typename T>
 class Node {
 public:
-  Node(const T& v) : val{v}, key{std::hash<T>{}(v)} { }
+  Node(const T& v) : key{std::hash<T>{}(v)}, val{v} { }
 
   // to create sentinels
-  Node(const T& v, const std::size_t k) : val{v}, key{k} { }
+  Node(const T& v, const std::size_t k) : key{k}, val{v} { }
 
   std::shared_ptr<Node<T>> next;
   std::mutex mutex;
@@ -40,10 +40,10 @@ private:
 template <typename T>
 class MarkedNode {
 public:
-  MarkedNode(const T& v) : val{v}, key{std::hash<T>{}(v)} { }
+  MarkedNode(const T& v) : key{std::hash<T>{}(v)}, val{v} { }
 
   // to create sentinels
-  MarkedNode(const T& v, const std::size_t k) : val{v}, key{k} { }
+  MarkedNode(const T& v, const std::size_t k) : key{k}, val{v} { }
 
   std::shared_ptr<MarkedNode<T>> next{nullptr};
   std::mutex mutex;
@@ -56,23 +56,32 @@ public:
 template <typename T>
 class LockFreeNode {
 public:
-  LockFreeNode(const T& v) : val{v}, key{std::hash<T>{}(v)} { }
-  LockFreeNode(const T& v, const std::size_t k) : val{v}, key{k} { }
+  LockFreeNode(const T& v) : key{std::hash<T>{}(v)}, val{v} { }
+  LockFreeNode(const T& v, const std::size_t k) : key{k}, val{v} { }
 
   /* Returns true if THIS node is removed. Note that the flag is stored
    * in the AtomicMarkableReference */
-  bool isRemoved() {
+  bool isRemoved() const {
     return next.isMarked();
   }
 
-  void setNext(std::shared_ptr<T> succ) {
-    next = AtomicMarkableReference<LockFreeNode<T>>(succ, false);
+  void setNext(LockFreeNode<T>* succ) {
+    next.set(succ, false);
   }
 
-  /* Try to mark this node as removed, return true if successful */
+  /* Try to mark this node as removed, return true if THIS call marked it.
+   * Only one remover can win, which is what makes remove() linearizable. */
   bool attemptMarkAsRemoved() {
-    std::shared_ptr<LockFreeNode<T>> nextPtr = next.getReference();
-    return next.attemptMark(nextPtr, true);
+    while (true) {
+      auto [succ, marked] = next.getRefAndMark();
+      if (marked) {
+        return false;
+      }
+      if (next.compareAndSet(succ, succ, false, true)) {
+        return true;
+      }
+      // an insert after this node moved succ, try again
+    }
   }
 
   // TODO: make private
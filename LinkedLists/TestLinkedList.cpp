@@ -233,7 +233,7 @@ int main(int argc, char** argv) {
   } else if (list_type == 'W') {  // Lock-free list
     if (mode == 'S') {
       LockFreeList<int> lst{};
-      singleThreadedTest<int>(lst);
+      singleThreadedTest2<int>(lst);
 
       // std::array<LockFreeNode<int>, 2> arr = {LockFreeNode{2}, LockFreeNode{3}};
       // AtomicMarkableReference<LockFreeNode<int>> ref1{&arr[0], true};
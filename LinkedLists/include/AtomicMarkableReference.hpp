@@ -1,61 +1,83 @@
 #ifndef ATOMIC_MARKABLE_REFERENCE_HPP
 #define ATOMIC_MARKABLE_REFERENCE_HPP
 
-#include <memory>  // shared_ptr
-#include <atomic>  // atomic
+#include <atomic>   // atomic
+#include <cstdint>  // uintptr_t
 #include <utility>  // pair
-#include <iostream>
 
+/* A pointer and a mark bit updated together by a single CAS, like Java's
+ * AtomicMarkableReference. Nodes are at least 2-byte aligned, so the mark is
+ * kept in the low bit of the pointer and the whole thing is one word.
+ *
+ * The reference is a plain T*: who frees the node is up to the container
+ * (see EpochReclamation), so following a reference costs a load and no
+ * reference count update. */
 template <typename T>
 class AtomicMarkableReference {
 public:
-  AtomicMarkableReference(T* ref, bool mark) {
-    int mark_mask = mark ? 1 : 0;
-    T* marked_ref = (T*) ((uintptr_t) ref | mark_mask);
-    markedRef.store(std::shared_ptr<T>{marked_ref});
+  AtomicMarkableReference(T* ref, bool mark) : markedRef{pack(ref, mark)} {
+    static_assert(alignof(T) >= 2, "the low bit of a T* must be free for the mark");
   }
 
-  bool compareAndSet(const std::shared_ptr<T> expectedRef,
-                     const std::shared_ptr<T> newRef,
-                     bool expectedMark,
-                     bool newMark) {
-    std::shared_ptr<T> oldMarkedRef{(T*) ((uintptr_t) expectedRef | expectedMark)};
-    std::shared_ptr<T> newMarkedRef{(T*) ((uintptr_t) newRef | newMark)};
-    return markedRef.compare_exchange_strong(oldMarkedRef, newMarkedRef);
+  AtomicMarkableReference(const AtomicMarkableReference&) = delete;
+  AtomicMarkableReference& operator=(const AtomicMarkableReference&) = delete;
+
+  /* Sets both if the current reference and mark are the expected ones */
+  bool compareAndSet(T* expectedRef, T* newRef, bool expectedMark, bool newMark) {
+    std::uintptr_t expected = pack(expectedRef, expectedMark);
+    return markedRef.compare_exchange_strong(expected, pack(newRef, newMark),
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_acquire);
   }
 
-  bool attemptMark(const T* expectedRef, bool newMark) {
-    // TODO: what if it is already marked?
-    std::shared_ptr<T> newMarkedRef{(T*) ((uintptr_t) expectedRef | newMark)};
-    std::shared_ptr<T> oldUnmarkedRef{expectedRef};
-    return markedRef.compare_exchange_strong(oldUnmarkedRef, newMarkedRef);
+  /* Sets the mark if the current reference is expectedRef, whatever the
+   * current mark. Returns true if the mark is newMark afterwards. */
+  bool attemptMark(T* expectedRef, bool newMark) {
+    std::uintptr_t current = markedRef.load(std::memory_order_acquire);
+    while (unpackRef(current) == expectedRef) {
+      if (unpackMark(current) == newMark ||
+          markedRef.compare_exchange_weak(current, pack(expectedRef, newMark),
+                                          std::memory_order_acq_rel,
+                                          std::memory_order_acquire)) {
+        return true;
+      }
+    }
+    return false;
   }
 
-  std::shared_ptr<T> getReference() {
-    return std::shared_ptr<T>(((uintptr_t) markedRef.load()) & ((uintptr_t) ~1));
+  void set(T* ref, bool mark) {
+    markedRef.store(pack(ref, mark), std::memory_order_release);
   }
 
-  std::pair<std::shared_ptr<T>, bool> getRefAndMark() {
-    uintptr_t marked_ref = (uintptr_t) markedRef.load();
-    
-    std::shared_ptr<T> ref{(marked_ref & ((uintptr_t) ~1))};
-    bool mark = marked_ref & 1;
+  T* getReference() const {
+    return unpackRef(markedRef.load(std::memory_order_acquire));
+  }
 
-    return std::make_pair<std::shared_ptr<T>, bool>(ref, mark);
+  /* Both read at the same instant */
+  std::pair<T*, bool> getRefAndMark() const {
+    std::uintptr_t current = markedRef.load(std::memory_order_acquire);
+    return std::make_pair(unpackRef(current), unpackMark(current));
   }
 
   // Atomically check whether the reference has been marked
-  bool isMarked() {
-    return ((uintptr_t) markedRef.load()) & 1;
+  bool isMarked() const {
+    return unpackMark(markedRef.load(std::memory_order_acquire));
   }
 
 private:
-  std::atomic<std::shared_ptr<T>> markedRef{nullptr};
+  static std::uintptr_t pack(T* ref, bool mark) {
+    return reinterpret_cast<std::uintptr_t>(ref) | (mark ? 1 : 0);
+  }
+
+  static T* unpackRef(std::uintptr_t markedRef) {
+    return reinterpret_cast<T*>(markedRef & ~(std::uintptr_t) 1);
+  }
+
+  static bool unpackMark(std::uintptr_t markedRef) {
+    return markedRef & 1;
+  }
 
-  // TODO: this class should be no more than a wrapper, only field should be the ptr.
-  // I believe it can be done with a atomic_uintptr_t, so try to do it with atomic<shared_ptr> to get benefits of
-  // automatic memory deallocation.
+  std::atomic<std::uintptr_t> markedRef;
 };
 
 #endif
-
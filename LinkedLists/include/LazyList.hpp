@@ -52,9 +52,9 @@ public:
     std::shared_ptr<MarkedNode<T>> curr = head->next;
     while (key > curr->key) {
       pred = curr;
-      curr = curr.next;
+      curr = curr->next;
     }
-    return !curr->removed && curr->next == key;
+    return !curr->removed && curr->key == key;
   }
 
 private:
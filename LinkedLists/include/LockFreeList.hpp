@@ -1,58 +1,81 @@
 #ifndef LOCK_FREE_LIST_HPP
 #define LOCK_FREE_LIST_HPP
 
-#include <memory>   // shared_ptr
+#include <atomic>
+#include <functional>  // std::hash
+#include <limits>   // std::numeric_limits
 #include <tuple>    // tie
 #include <utility>  // pair
 #ifdef ENABLE_LOGGING
+  #include <cstdio>  // std::printf
   #include <chrono>
+  #include <thread>
 #endif
 #include "LinkedListConcept.hpp"
 #include "AtomicMarkableReference.hpp"
-
+#include "EpochReclamation.hpp"  // ../Reclamation
+
+/* Harris-Michael lock-free list. A node is removed in two steps: remove()
+ * marks its next reference (logical removal, the linearization point), then
+ * whoever manages to swing pred->next past it (remove() itself or a later
+ * find()) unlinks it and retires it to the epoch domain. Every operation runs
+ * inside an EpochReclamation::Guard, so a node stays readable for as long as
+ * any thread that may have reached it is still inside its operation, and
+ * traversals are plain loads with no reference counting. */
 template <typename T>
 class LockFreeList {
 public:
-  LockFreeList() {
-    std::shared_ptr<LockFreeNode<T>>
-      head_ = std::make_shared<LockFreeNode<T>>(T(), 0);
-    std::shared_ptr<LockFreeNode<T>>
-      tail_ = std::make_shared<LockFreeNode<T>>(T(), std::numeric_limits<std::size_t>::max());
-
-    head = AtomicMarkableReference<LockFreeNode<T>>(head_.get(), false);
-    tail = AtomicMarkableReference<LockFreeNode<T>>(tail_.get(), false);
-    head.getReference()->setNext(tail);
+  explicit LockFreeList(EpochReclamation& domain = EpochReclamation::global()) : ebr{domain} {
+    head = new LockFreeNode<T>(T(), 0);
+    tail = new LockFreeNode<T>(T(), std::numeric_limits<std::size_t>::max());
+    head->setNext(tail);
 
     #ifdef ENABLE_LOGGING
       start = std::chrono::high_resolution_clock::now();
     #endif
   }
 
+  /* Only once no other thread uses the list. Nodes already retired belong
+   * to the domain. */
+  ~LockFreeList() {
+    LockFreeNode<T>* curr = head;
+    while (curr != nullptr) {
+      LockFreeNode<T>* next = curr->next.getReference();
+      delete curr;
+      curr = next;
+    }
+  }
+
+  LockFreeList(const LockFreeList&) = delete;
+  LockFreeList& operator=(const LockFreeList&) = delete;
+
   bool add(const T& val) {
     std::size_t key = std::hash<T>{}(val);
     bool isSuccessful{false};
-    while (true) {
-      std::shared_ptr<LockFreeNode<T>> pred, curr;
-      std::tie(pred, curr) = find(key);
+    LockFreeNode<T>* newNode = nullptr;
+    {
+      EpochReclamation::Guard guard{ebr};
+      while (true) {
+        auto [pred, curr] = find(key);
+
+        if (curr->key == key) {
+          isSuccessful = false;
+          break;
+        }
 
-      if (curr->key == key) {
-        isSuccessful = false;
-        break;
-      } else {
-        // create newNode
-        std::shared_ptr<LockFreeNode<T>> newNode = std::make_shared<LockFreeNode<T>>(val);
+        if (newNode == nullptr) {
+          newNode = new LockFreeNode<T>(val);
+        }
         // point newNode->curr
         newNode->setNext(curr);
 
         // try to point pred -> newNode
         if (pred->next.compareAndSet(curr, newNode, false, false)) {
-          size++;
+          size.fetch_add(1, std::memory_order_relaxed);
           isSuccessful = true;
           break;
         }
 
-        // could not point pred->newNode... restarting add()
-
         // pred->newNode fails if another thread either
         //   - marks pred as removed
         //   - inserts some other node after pred
@@ -60,6 +83,9 @@ public:
         // showing why it is needed to physically remove nodes in find()
       }
     }
+    if (!isSuccessful) {
+      delete newNode;  // never published
+    }
 
     #ifdef ENABLE_LOGGING
       std::chrono::time_point<std::chrono::high_resolution_clock> now = std::chrono::high_resolution_clock::now();
@@ -69,7 +95,7 @@ public:
                   "ADD",
                   key,
                   isSuccessful ? "true" : "false",
-                  size,
+                  size.load(),
                   time);
     #endif
 
@@ -79,21 +105,31 @@ public:
   bool remove(const T& val) {
     std::size_t key = std::hash<T>{}(val);
     bool isSuccessful{false};
-    while (true) {
-      std::shared_ptr<LockFreeNode<T>> pred, curr;
-      std::tie(pred, curr) = find(key);
+    {
+      EpochReclamation::Guard guard{ebr};
+      while (true) {
+        auto [pred, curr] = find(key);
 
-      if (curr->key != key) {
-        isSuccessful = false;
-        break;
-      } else {
-        // attempt to logically remove, restart if failed
-        if (curr->attemptMarkAsRemoved()) {
-          // CAS pred -> curr.next ?
-          isSuccessful = true;
-          size--;
+        if (curr->key != key) {
+          isSuccessful = false;
           break;
         }
+
+        // attempt to logically remove, restart if another thread got there first
+        if (!curr->attemptMarkAsRemoved()) {
+          continue;
+        }
+        isSuccessful = true;
+        size.fetch_sub(1, std::memory_order_relaxed);
+
+        // attempt to physically remove; if pred changed, let find() do it
+        LockFreeNode<T>* succ = curr->next.getReference();
+        if (pred->next.compareAndSet(curr, succ, false, false)) {
+          ebr.retire(curr);
+        } else {
+          find(key);
+        }
+        break;
       }
     }
 
@@ -105,65 +141,65 @@ public:
                   "REM",
                   key,
                   isSuccessful ? "true" : "false",
-                  size,
+                  size.load(),
                   time);
     #endif
 
     return isSuccessful;
   }
 
+  /* Wait-free: never helps, never restarts */
   bool contains(const T& val) {
     std::size_t key = std::hash<T>{}(val);
-    bool isCurrRemoved[1] = {false};
-    std::shared_ptr<LockFreeNode<T>> curr = head.getReference();
+    EpochReclamation::Guard guard{ebr};
+    LockFreeNode<T>* curr = head;
     while (curr->key < key) {
       curr = curr->next.getReference();
     }
     return curr->key == key && !curr->isRemoved();
   }
 
+  std::size_t getSize() const {
+    return size.load(std::memory_order_relaxed);
+  }
+
 private:
-  std::pair<std::shared_ptr<LockFreeNode<T>>,
-            std::shared_ptr<LockFreeNode<T>>>
-  find(const std::size_t key) {
+  /* Returns pred, curr with pred->key < key <= curr->key, both unmarked when
+   * read, unlinking and retiring every marked node on the way. Must be
+   * called inside a guard. */
+  std::pair<LockFreeNode<T>*, LockFreeNode<T>*> find(const std::size_t key) {
+  retry:
+    LockFreeNode<T>* pred = head;
+    LockFreeNode<T>* curr = pred->next.getReference();
     while (true) {
-      std::shared_ptr<LockFreeNode<T>> pred = head.getReference();
-      std::shared_ptr<LockFreeNode<T>> curr = pred->next;
-      while (curr->key < key) {
-        // if curr is logically removed, try to physically remove it
-        if (curr->isRemoved()) {
-          if (!pred->next.compareAndSet(curr, curr->next.getReference(),
-                                        false, false)) {
-            // restart find() if could not physically remove
-            //   - pred might have been removed
-            //   - a node might have been inserted between pred and curr
-            break;
-          }
+      auto [succ, marked] = curr->next.getRefAndMark();
+      while (marked) {
+        // curr is logically removed, try to physically remove it
+        if (!pred->next.compareAndSet(curr, succ, false, false)) {
+          // restart find() if could not physically remove
+          //   - pred might have been removed
+          //   - a node might have been inserted between pred and curr
+          goto retry;
         }
-        pred = curr;
-        curr = curr->next.getReference();
+        ebr.retire(curr);
+        curr = succ;
+        std::tie(succ, marked) = curr->next.getRefAndMark();
       }
-
-      while (pred->next.compareAndSet(curr, curr->next.getReference(),
-                                      true, false)) {
-        curr = curr->next.getReference();
+      if (curr->key >= key) {
+        return std::make_pair(pred, curr);
       }
-
-      return std::make_pair(pred, pred->next.getReference());
+      pred = curr;
+      curr = succ;
     }
-
-    // unreachable
-    assert(false);
-    return std::make_pair(nullptr, nullptr);
   }
 
-  AtomicMarkableReference<LockFreeNode<T>> head{nullptr, false};
-  AtomicMarkableReference<LockFreeNode<T>> tail{nullptr, false};
-  std::size_t size{0};
+  EpochReclamation& ebr;
+  LockFreeNode<T>* head;
+  LockFreeNode<T>* tail;
+  std::atomic<std::size_t> size{0};
   #ifdef ENABLE_LOGGING
     std::chrono::time_point<std::chrono::high_resolution_clock> start;
   #endif
 };
 
 #endif
-
@@ -0,0 +1,115 @@
+#ifndef BLOCKING_QUEUE_HPP
+#define BLOCKING_QUEUE_HPP
+
+#include <concepts>
+#include <optional>
+#include <utility>    // forward, move
+#include "WaitStrategy.hpp"
+
+/* Blocking push/pop over any of the queues in this directory:
+ *
+ *     BlockingQueue<BoundedMPMCQueue<Task>, ParkWait> tasks{1024};
+ *     tasks.push(task);         // waits while full
+ *     Task next = tasks.pop();  // waits while empty
+ *
+ * Consumers wait for elements and producers for free slots with the Wait
+ * policy, so the same queue type serves a latency-critical consumer
+ * (BusySpinWait) or a background one (ParkWait, EventfdWait) depending on
+ * how it is instantiated. Unbounded queues never fill, so their producers
+ * never wait. The single-producer/consumer queues keep their restriction.
+ *
+ * Uses try_enqueue/try_dequeue(T&) where the queue has them, else
+ * enqueue (unbounded) and dequeue(T&). */
+template <typename Q, WaitStrategyConcept Wait = ParkWait>
+class BlockingQueue {
+public:
+    using value_type = typename Q::value_type;
+    using T = value_type;
+
+    template <typename... Args>
+    requires std::constructible_from<Q, Args...>
+    explicit BlockingQueue(Args&&... args) : q(std::forward<Args>(args)...) {}
+
+    BlockingQueue(const BlockingQueue&) = delete;
+    BlockingQueue& operator=(const BlockingQueue&) = delete;
+
+    void push(T v) {
+        writable.until([&]() { return tryEnqueue(std::move(v)); });
+        readable.notify();
+    }
+
+    T pop() {
+        T v;
+        readable.until([&]() { return tryDequeue(v); });
+        writable.notify();
+        return v;
+    }
+
+    bool try_push(const T& v) {
+        return tryPush(v);
+    }
+
+    /* Moves from v only on success */
+    bool try_push(T&& v) {
+        return tryPush(std::move(v));
+    }
+
+    bool try_pop(T& out) {
+        if (!tryDequeue(out)) {
+            return false;
+        }
+        writable.notify();
+        return true;
+    }
+
+    /* The underlying queue */
+    Q& queue() {
+        return q;
+    }
+
+    /* What consumers wait on, e.g. to register readableWait().fd() with
+     * epoll when Wait is EventfdWait */
+    Wait& readableWait() {
+        return readable;
+    }
+
+    /* What producers wait on */
+    Wait& writableWait() {
+        return writable;
+    }
+
+private:
+    template <typename U>
+    bool tryPush(U&& v) {
+        if (!tryEnqueue(std::forward<U>(v))) {
+            return false;
+        }
+        readable.notify();
+        return true;
+    }
+
+    /* An rvalue is moved from only on success */
+    template <typename U>
+    bool tryEnqueue(U&& v) {
+        if constexpr (requires { q.try_enqueue(std::forward<U>(v)); }) {
+            return q.try_enqueue(std::forward<U>(v));
+        } else {
+            q.enqueue(T(std::forward<U>(v)));
+            return true;
+        }
+    }
+
+    bool tryDequeue(T& out) {
+        if constexpr (requires { q.try_dequeue(out); }) {
+            return q.try_dequeue(out);
+        } else {
+            return q.dequeue(out);
+        }
+    }
+
+    Q q;
+    Wait readable;  // consumers wait here for elements
+    Wait writable;  // producers wait here for free slots
+};
+
+#endif
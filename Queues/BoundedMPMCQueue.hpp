@@ -0,0 +1,162 @@
+#ifndef BOUNDED_MPMC_QUEUE_HPP
+#define BOUNDED_MPMC_QUEUE_HPP
+
+#include <atomic>
+#include <bit>        // bit_ceil
+#include <cstddef>
+#include <cstdint>
+#include <memory>     // unique_ptr, construct_at, destroy_at
+#include <new>        // launder
+#include <optional>
+#include <thread>     // yield
+#include <utility>    // forward, move
+#include "Backoff.hpp"  // cpuRelax
+#include "CacheLine.hpp"
+
+/* Bounded multi-producer multi-consumer ring (Vyukov). No allocation after
+ * construction and no locks: a producer claims position pos by CAS on
+ * enqueuePos, a consumer by CAS on dequeuePos, and each cell's sequence
+ * number says whose turn the cell is:
+ *
+ *   sequence == pos             free, for the producer of pos
+ *   sequence == pos + 1         full, for the consumer of pos
+ *   sequence == pos + capacity  free again, for the producer one lap later
+ *
+ * A thread only writes a cell after winning its position, and publishes
+ * the cell with a release store of the next sequence number, so producers
+ * and consumers never block each other except on the two counters (each on
+ * its own cache line) and on the same cell.
+ *
+ * try_ operations fail on full/empty; enqueue/dequeue wait (spin, then
+ * yield) until they succeed. */
+template <typename T>
+class BoundedMPMCQueue {
+public:
+    using value_type = T;
+
+    static constexpr unsigned SPIN_LIMIT = 1024;  // cpuRelax()es before a blocked caller yields
+
+    explicit BoundedMPMCQueue(std::size_t capacity)
+    : mask{std::bit_ceil(capacity) - 1},
+      cells{std::make_unique<Cell[]>(mask + 1)} {
+        for (std::size_t i = 0; i <= mask; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~BoundedMPMCQueue() {
+        while (try_dequeue()) {}
+    }
+
+    BoundedMPMCQueue(const BoundedMPMCQueue&) = delete;
+    BoundedMPMCQueue& operator=(const BoundedMPMCQueue&) = delete;
+
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        std::size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells[pos & mask];
+            std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            std::intptr_t diff = (std::intptr_t) seq - (std::intptr_t) pos;
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // the cell still holds the element from one lap ago
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);  // another producer got pos
+            }
+        }
+        std::construct_at(cell->value(), std::forward<Args>(args)...);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_enqueue(const T& v) {
+        return try_emplace(v);
+    }
+
+    bool try_enqueue(T&& v) {
+        return try_emplace(std::move(v));
+    }
+
+    bool try_dequeue(T& out) {
+        std::optional<T> v = try_dequeue();
+        if (!v) {
+            return false;
+        }
+        out = std::move(*v);
+        return true;
+    }
+
+    std::optional<T> try_dequeue() {
+        std::size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells[pos & mask];
+            std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            std::intptr_t diff = (std::intptr_t) seq - (std::intptr_t) (pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return std::nullopt;  // the producer of pos has not published yet
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        std::optional<T> result{std::move(*cell->value())};
+        std::destroy_at(cell->value());
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return result;
+    }
+
+    void enqueue(T v) {
+        for (unsigned i = 0; !try_emplace(std::move(v)); i++) {
+            pause(i);
+        }
+    }
+
+    T dequeue() {
+        for (unsigned i = 0; ; i++) {
+            std::optional<T> v = try_dequeue();
+            if (v) {
+                return std::move(*v);
+            }
+            pause(i);
+        }
+    }
+
+    std::size_t capacity() const {
+        return mask + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        alignas(T) std::byte storage[sizeof(T)];
+
+        T* value() {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+
+    static void pause(unsigned i) {
+        if (i < SPIN_LIMIT) {
+            cpuRelax();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    // read-only after construction
+    alignas(CACHE_LINE_SIZE) const std::size_t mask;
+    const std::unique_ptr<Cell[]> cells;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> enqueuePos{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> dequeuePos{0};
+};
+
+#endif
@@ -1,11 +1,46 @@
 #ifndef MIN_SPSC_QUEUE_HPP
 #define MIN_SPSC_QUEUE_HPP
 
-#define CAPACITY 1024
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <utility>  // move
+#include "CacheLine.hpp"
 
-/* Queue stops working after exception is thrown */
+/* Minimal single-producer single-consumer ring of Capacity elements of T.
+ *
+ * head and tail only ever grow, so pos % Capacity is the slot and
+ * tail - head the number of elements. Besides one-at-a-time enqueue and
+ * dequeue, both sides can move whole batches and publish their index once
+ * per batch:
+ *   - enqueue_bulk/dequeue_bulk copy from/into a span
+ *   - reserve(n)/commit(n) and peek(n)/release(n) hand out the ring's own
+ *     slots (as two spans, split where the ring wraps around), so a
+ *     producer can write records straight into the buffer
+ *
+ * The slots hold constructed T's all the time, hence T must be default
+ * constructible; elements are assigned in and moved out. */
+template <typename T, std::size_t Capacity>
 class MinSPSCQueue {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "Capacity must be a power of two");
+
 public:
+  using value_type = T;
+
+  /* Contiguous slots of the ring: 'first' up to the end of the buffer,
+   * 'second' from its start when the region wraps around */
+  struct Region {
+    std::span<T> first;
+    std::span<T> second;
+
+    std::size_t size() const {
+      return first.size() + second.size();
+    }
+  };
+
   MinSPSCQueue() {}
 
   /* Single-producer ==> only one thread is calling enqueue at a time
@@ -13,43 +48,114 @@ public:
    *
    * Reads from head
    * Updates tail
+   *
+   * Returns false if the queue is full; v is only moved from on success.
    */
-  void enqueue(int v) {
-    size_t front_pos = head.load(std::memory_order_relaxed);
+  template <typename U>
+  bool try_enqueue(U&& v) {
+    size_t front_pos = head.load(std::memory_order_acquire);
     // only one thread can be enqueueing at a time
     size_t pos = tail.load(std::memory_order_relaxed);
 
-    if (pos - front_pos >= CAPACITY) {
-      throw std::runtime_error("enqueueing to full queue");
+    if (pos - front_pos >= Capacity) {
+      return false;
     }
 
     /* P1. Producer prepares data */
-    ringBuffer[pos % CAPACITY] = v;
+    ringBuffer[pos % Capacity] = std::forward<U>(v);
 
     /* P2. Producer publishes data */
     tail.store(pos + 1, std::memory_order_release);
+    return true;
   }
 
   /* Reads from tail
-   * Updates head */
-  int dequeue() {
+   * Updates head
+   *
+   * Returns false if the queue is empty */
+  bool try_dequeue(T& out) {
     /* P3. Consumer receives published data */
     size_t tail_pos = tail.load(std::memory_order_acquire);
 
-    size_t pos = head.fetch_add(1, std::memory_order_relaxed);  // incremented head becomes visible to producer
-    if (pos == tail_pos)
-      throw std::runtime_error("dequeueing from empty queue");
+    size_t pos = head.load(std::memory_order_relaxed);
+    if (pos == tail_pos) {
+      return false;
     }
 
-    int tmp = ringBuffer[pos % CAPACITY];
+    out = std::move(ringBuffer[pos % Capacity]);
+    head.store(pos + 1, std::memory_order_release);  // slot may be reused from here on
+    return true;
+  }
+
+  void enqueue(T v) {
+    if (!try_enqueue(std::move(v))) {
+      throw std::runtime_error("enqueueing to full queue");
+    }
+  }
+
+  T dequeue() {
+    T tmp;
+    if (!try_dequeue(tmp)) {
+      throw std::runtime_error("dequeueing from empty queue");
+    }
     return tmp;
   }
 
+  /* Producer: up to n free slots starting at tail. Fill them, then
+   * commit() how many were filled. */
+  Region reserve(size_t n) {
+    size_t pos = tail.load(std::memory_order_relaxed);
+    size_t free = Capacity - (pos - head.load(std::memory_order_acquire));
+    return region(pos, std::min(n, free));
+  }
+
+  /* Producer: publishes the first n slots of the last reserve() at once */
+  void commit(size_t n) {
+    tail.store(tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+  }
+
+  /* Consumer: up to n published elements starting at head. Read (or move
+   * out of) them, then release() how many were consumed. */
+  Region peek(size_t n) {
+    size_t pos = head.load(std::memory_order_relaxed);
+    size_t available = tail.load(std::memory_order_acquire) - pos;
+    return region(pos, std::min(n, available));
+  }
+
+  /* Consumer: hands the first n slots of the last peek() back to the producer */
+  void release(size_t n) {
+    head.store(head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+  }
+
+  /* Enqueues as many of 'items' as fit, returns how many */
+  size_t enqueue_bulk(std::span<const T> items) {
+    Region r = reserve(items.size());
+    std::copy_n(items.begin(), r.first.size(), r.first.begin());
+    std::copy_n(items.begin() + r.first.size(), r.second.size(), r.second.begin());
+    commit(r.size());
+    return r.size();
+  }
+
+  /* Dequeues up to out.size() elements into 'out', returns how many */
+  size_t dequeue_bulk(std::span<T> out) {
+    Region r = peek(out.size());
+    auto next = std::move(r.first.begin(), r.first.end(), out.begin());
+    std::move(r.second.begin(), r.second.end(), next);
+    release(r.size());
+    return r.size();
+  }
+
 private:
-  std::atomic<size_t> head{0};
-  std::atomic<size_t> tail{0};
-  int ringBuffer[CAPACITY];
+  Region region(size_t pos, size_t n) {
+    size_t start = pos % Capacity;
+    size_t firstLen = std::min(n, Capacity - start);
+    return Region{std::span<T>{ringBuffer + start, firstLen},
+                  std::span<T>{ringBuffer, n - firstLen}};
+  }
+
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> head{0};
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail{0};
+  alignas(CACHE_LINE_SIZE) T ringBuffer[Capacity];
 };
 
 #endif
-
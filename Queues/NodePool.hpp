@@ -0,0 +1,243 @@
+#ifndef NODE_POOL_HPP
+#define NODE_POOL_HPP
+
+#include <algorithm>  // clamp, min
+#include <atomic>
+#include <cstddef>
+#include <memory>     // unique_ptr
+#include <mutex>
+#include <vector>
+#include "CacheLine.hpp"
+#include "ThreadIndex.hpp"
+
+/* Per-container pool of uninitialized storage for T, for queues that would
+ * otherwise call new/delete on every operation.
+ *
+ * Each thread (by ThreadIndex) allocates from and frees to its own cache, a
+ * list only that thread touches, so the common case is a pointer swap with
+ * no atomics and no lock. When a cache runs dry it takes a batch of blocks
+ * from the shared list; when it holds two batches it hands one back. That
+ * matters for queues, where producers allocate and consumers free: blocks
+ * flow back to the producers in batches.
+ *
+ * A batch handed back goes to the cache's 'spare' slot if that is empty,
+ * else to the shared list (under its mutex). Any thread can empty a spare
+ * slot with one exchange, the owner to refill its cache and the others to
+ * steal, so blocks in transit stay reachable without a lock on the owner's
+ * path.
+ *
+ * A growable pool refills the shared list with a new slab of SLAB_SIZE
+ * blocks when it is empty, and moves BATCH blocks at a time. A fixed pool
+ * gets all its blocks up front and never calls malloc again; when the shared
+ * list is empty it steals spare slots before allocate() gives up with
+ * nullptr. Blocks inside a cache are only handed back by their owner, so a
+ * fixed pool's batch is at most a sixteenth of its blocks, and once an
+ * allocation has come up short every owner's next deallocate() hands its
+ * whole cache back instead of waiting for two batches. A thread that stops
+ * using a fixed pool keeps the (fewer than 2 * batch) blocks in its cache
+ * until its index is reused.
+ *
+ * Threads past MAX_THREADS have no cache and go to the shared list every
+ * time; deallocate() never throws.
+ *
+ * allocate() returns raw storage: construct with std::construct_at, destroy
+ * before deallocate(). Slabs are freed with the pool. */
+template <typename T>
+class NodePool {
+public:
+    static constexpr unsigned MAX_THREADS = 256;
+    // a growable pool's batch; a fixed pool's is blocks / 16, clamped to [1, BATCH]
+    static constexpr std::size_t BATCH = 32;
+    static constexpr std::size_t SLAB_SIZE = 256;  // blocks per slab of a growable pool
+
+    /* 'blocks' allocated up front; a fixed pool never has more */
+    explicit NodePool(std::size_t blocks = 0, bool growable = true)
+        : growable{growable}, batch{growable ? BATCH : std::clamp<std::size_t>(blocks / 16, 1, BATCH)} {
+        if (blocks > 0) {
+            addSlab(blocks);
+        }
+    }
+
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    /* nullptr only if the pool is fixed and every block is in use */
+    T* allocate() {
+        Cache* me = mine();
+        if (me && me->head) {
+            return take(*me);
+        }
+
+        std::size_t count = 0;
+        Block* blocks = me ? takeSpare(*me, count) : nullptr;
+        if (!blocks) {
+            blocks = takeShared(count);
+        }
+        if (!blocks) {
+            starved.store(true, std::memory_order_relaxed);
+            blocks = steal(count);
+            if (!blocks) {
+                return nullptr;
+            }
+        }
+        if (!me) {
+            // no cache to keep the rest in
+            if (count > 1) {
+                std::lock_guard<std::mutex> guard{sharedMutex};
+                splice(shared, sharedCount, blocks->next, count - 1);
+            }
+            return reinterpret_cast<T*>(blocks->storage);
+        }
+        me->head = blocks;
+        me->count = count;
+        return take(*me);
+    }
+
+    void deallocate(T* p) {
+        Block* block = reinterpret_cast<Block*>(p);
+        Cache* me = mine();
+        if (!me) {
+            block->next = nullptr;
+            std::lock_guard<std::mutex> guard{sharedMutex};
+            splice(shared, sharedCount, block, 1);
+            return;
+        }
+        block->next = me->head;
+        me->head = block;
+        if (++me->count >= 2 * batch) {
+            handBack(*me, batch);
+        } else if (starved.load(std::memory_order_relaxed) &&
+                   starved.exchange(false, std::memory_order_relaxed)) {
+            handBack(*me, me->count);
+        }
+    }
+
+private:
+    union Block {
+        Block* next;  // while free
+        alignas(T) std::byte storage[sizeof(T)];
+    };
+
+    struct alignas(CACHE_LINE_SIZE) Cache {
+        // owner only
+        Block* head{nullptr};
+        std::size_t count{0};
+        // a chain of at most 'batch' blocks; the owner fills it when empty,
+        // anyone empties it with exchange
+        alignas(CACHE_LINE_SIZE) std::atomic<Block*> spare{nullptr};
+    };
+
+    static T* take(Cache& cache) {
+        Block* block = cache.head;
+        cache.head = block->next;
+        cache.count--;
+        return reinterpret_cast<T*>(block->storage);
+    }
+
+    /* Unlinks the first n (<= count) blocks of list and returns them */
+    static Block* detach(Block*& list, std::size_t& count, std::size_t n) {
+        Block* first = list;
+        Block* last = first;
+        for (std::size_t i = 1; i < n; i++) {
+            last = last->next;
+        }
+        list = last->next;
+        last->next = nullptr;
+        count -= n;
+        return first;
+    }
+
+    /* Prepends the n-block chain 'blocks' to list */
+    static void splice(Block*& list, std::size_t& count, Block* blocks, std::size_t n) {
+        Block* last = blocks;
+        while (last->next) {
+            last = last->next;
+        }
+        last->next = list;
+        list = blocks;
+        count += n;
+    }
+
+    /* The whole chain in cache's spare slot, if any */
+    static Block* takeSpare(Cache& cache, std::size_t& count) {
+        if (!cache.spare.load(std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        Block* blocks = cache.spare.exchange(nullptr, std::memory_order_acquire);
+        count = 0;
+        for (Block* b = blocks; b; b = b->next) {
+            count++;
+        }
+        return blocks;
+    }
+
+    /* Moves n blocks out of the owner's cache */
+    void handBack(Cache& me, std::size_t n) {
+        Block* blocks = detach(me.head, me.count, n);
+        // only the owner stores a chain, so an empty slot stays empty until then
+        if (n <= batch && !me.spare.load(std::memory_order_relaxed)) {
+            me.spare.store(blocks, std::memory_order_release);
+            return;
+        }
+        std::lock_guard<std::mutex> guard{sharedMutex};
+        splice(shared, sharedCount, blocks, n);
+    }
+
+    /* Up to batch blocks from the shared list, growing it if allowed */
+    Block* takeShared(std::size_t& count) {
+        std::lock_guard<std::mutex> guard{sharedMutex};
+        if (sharedCount == 0) {
+            if (!growable) {
+                return nullptr;
+            }
+            addSlab(SLAB_SIZE);
+        }
+        count = std::min(batch, sharedCount);
+        return detach(shared, sharedCount, count);
+    }
+
+    /* Some other thread's spare blocks */
+    Block* steal(std::size_t& count) {
+        unsigned numCaches = activeCaches.load(std::memory_order_acquire);
+        for (unsigned i = 0; i < numCaches; i++) {
+            if (Block* blocks = takeSpare(caches[i], count)) {
+                return blocks;
+            }
+        }
+        return nullptr;
+    }
+
+    /* Caller holds sharedMutex, or is the constructor */
+    void addSlab(std::size_t blocks) {
+        std::unique_ptr<Block[]> slab{new Block[blocks]};
+        for (std::size_t i = 0; i + 1 < blocks; i++) {
+            slab[i].next = &slab[i + 1];
+        }
+        slab[blocks - 1].next = nullptr;
+        splice(shared, sharedCount, &slab[0], blocks);
+        slabs.push_back(std::move(slab));
+    }
+
+    /* nullptr past MAX_THREADS */
+    Cache* mine() {
+        unsigned index = ThreadIndex::get();
+        if (index >= MAX_THREADS) {
+            return nullptr;
+        }
+        // steal() only looks at caches below activeCaches
+        ThreadIndex::raiseHighWater(activeCaches, index);
+        return &caches[index];
+    }
+
+    const bool growable;
+    const std::size_t batch;  // blocks moved between a cache and the shared list
+    std::unique_ptr<Cache[]> caches{std::make_unique<Cache[]>(MAX_THREADS)};
+    std::atomic<unsigned> activeCaches{0};
+    alignas(CACHE_LINE_SIZE) std::atomic_bool starved{false};  // an allocation came up short
+    alignas(CACHE_LINE_SIZE) std::mutex sharedMutex;
+    Block* shared{nullptr};
+    std::size_t sharedCount{0};
+    std::vector<std::unique_ptr<Block[]>> slabs;
+};
+
+#endif
@@ -0,0 +1,484 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>  // bit_ceil
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>  // memcpy, memset
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <pthread.h>  // pthread_setaffinity_np
+#include <sys/wait.h>  // waitpid
+#include <unistd.h>  // fork
+
+#include "Backoff.hpp"  // cpuRelax
+#include "LockBenchmark.hpp"  // parseList
+#include "SPSCqueue.hpp"
+#include "MinSPSCqueue.hpp"
+#include "BoundedMPMCQueue.hpp"
+#include "UnboundedQueue.hpp"
+#include "UnboundedLockFreeQueue.hpp"
+#include "SegmentedFAAQueue.hpp"
+#include "BlockingQueue.hpp"
+#include "SharedMemoryRing.hpp"
+
+/* Moves 'items' values through each queue and checks that every value
+ * arrives exactly once and, per producer, in order.
+ *
+ * Writes CSV: queue,producers,consumers,items,seconds,throughput,correct */
+
+struct QueueConfig {
+    unsigned producers{1};
+    unsigned consumers{1};
+    std::uint64_t items{1 << 22};  // in total, split between the producers
+    std::size_t capacity{1024};  // MinSPSCQueue's is fixed at MIN_CAPACITY
+    std::size_t batch{64};  // elements per bulk operation
+    bool pin{false};  // thread i on CPU i % hardware_concurrency
+};
+
+struct QueueResult {
+    double seconds{0};
+    bool correct{false};
+};
+
+void pinToCpu(unsigned i) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(i % std::max(1u, std::thread::hardware_concurrency()), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+/* Retries op() until it succeeds; spins first, then yields so that a
+ * producer and consumer sharing a core still make progress */
+template <typename Op>
+void retry(Op op) {
+    for (unsigned i = 0; !op(); i++) {
+        if (i < 1024) {
+            cpuRelax();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+/* Items are plain integers, or boxed to exercise move-only element types */
+template <typename T>
+T makeItem(std::uint64_t v) {
+    if constexpr (std::is_same_v<T, std::unique_ptr<std::uint64_t>>) {
+        return std::make_unique<std::uint64_t>(v);
+    } else {
+        return v;
+    }
+}
+
+template <typename T>
+std::uint64_t itemValue(const T& item) {
+    if constexpr (std::is_same_v<T, std::unique_ptr<std::uint64_t>>) {
+        return *item;
+    } else {
+        return item;
+    }
+}
+
+template <typename T>
+QueueResult spsc(const QueueConfig& config) {
+    SPSCqueue<T> queue{config.capacity};
+    std::atomic_bool start{false};
+    bool inOrder = true;
+
+    std::thread producer{[&]() {
+        if (config.pin) {
+            pinToCpu(0);
+        }
+        while (!start.load(std::memory_order_acquire)) {}
+        for (std::uint64_t i = 0; i < config.items; i++) {
+            T item = makeItem<T>(i);
+            retry([&]() { return queue.try_enqueue(std::move(item)); });
+        }
+    }};
+    std::thread consumer{[&]() {
+        if (config.pin) {
+            pinToCpu(1);
+        }
+        while (!start.load(std::memory_order_acquire)) {}
+        T item;
+        for (std::uint64_t i = 0; i < config.items; i++) {
+            retry([&]() { return queue.try_dequeue(item); });
+            inOrder &= itemValue(item) == i;
+        }
+    }};
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    producer.join();
+    consumer.join();
+    auto end = std::chrono::steady_clock::now();
+
+    QueueResult result;
+    result.seconds = std::chrono::duration<double>(end - begin).count();
+    result.correct = inOrder && !queue.try_dequeue();
+    return result;
+}
+
+constexpr std::size_t MIN_CAPACITY = 1024;
+
+/* One element at a time (batch 1), or batches of up to config.batch written
+ * and read in place through reserve/commit and peek/release */
+template <bool Bulk>
+QueueResult minSpsc(const QueueConfig& config) {
+    auto queue = std::make_unique<MinSPSCQueue<std::uint64_t, MIN_CAPACITY>>();
+    std::size_t batch = Bulk ? config.batch : 1;
+    std::atomic_bool start{false};
+    bool inOrder = true;
+
+    std::thread producer{[&]() {
+        if (config.pin) {
+            pinToCpu(0);
+        }
+        while (!start.load(std::memory_order_acquire)) {}
+        std::uint64_t next = 0;
+        while (next < config.items) {
+            auto region = queue->reserve(std::min<std::uint64_t>(batch, config.items - next));
+            for (std::uint64_t& slot : region.first) {
+                slot = next++;
+            }
+            for (std::uint64_t& slot : region.second) {
+                slot = next++;
+            }
+            queue->commit(region.size());
+            if (region.size() == 0) {
+                retry([&]() { return queue->reserve(1).size() > 0; });
+            }
+        }
+    }};
+    std::thread consumer{[&]() {
+        if (config.pin) {
+            pinToCpu(1);
+        }
+        while (!start.load(std::memory_order_acquire)) {}
+        std::uint64_t expected = 0;
+        while (expected < config.items) {
+            auto region = queue->peek(batch);
+            for (std::uint64_t v : region.first) {
+                inOrder &= v == expected++;
+            }
+            for (std::uint64_t v : region.second) {
+                inOrder &= v == expected++;
+            }
+            queue->release(region.size());
+            if (region.size() == 0) {
+                retry([&]() { return queue->peek(1).size() > 0; });
+            }
+        }
+    }};
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    producer.join();
+    consumer.join();
+    auto end = std::chrono::steady_clock::now();
+
+    // the copying bulk calls, on the now idle queue
+    std::uint64_t in[3] = {1, 2, 3};
+    std::uint64_t out[4] = {};
+    bool bulkCopies = queue->enqueue_bulk(in) == 3 && queue->dequeue_bulk(out) == 3 &&
+                      out[0] == 1 && out[2] == 3;
+
+    QueueResult result;
+    result.seconds = std::chrono::duration<double>(end - begin).count();
+    result.correct = inOrder && bulkCopies && queue->peek(1).size() == 0;
+    return result;
+}
+
+/* Producer in a forked child that attaches to the parent's memfd ring by
+ * fd. Record i is 8 + i % 57 bytes: i, then i's low byte repeated; both
+ * sides work on the ring's bytes in place. The child leaves with _exit,
+ * without closing its end, so the parent must then see it as Dead. */
+QueueResult sharedMemory(const QueueConfig& config) {
+    using Role = SharedMemoryRing::Role;
+    SharedMemoryRing ring = SharedMemoryRing::createAnonymous(
+        std::bit_ceil(std::max<std::size_t>(64, config.capacity * 64)), Role::Consumer);
+
+    auto begin = std::chrono::steady_clock::now();
+    pid_t child = ::fork();
+    if (child < 0) {
+        return QueueResult{};
+    }
+    if (child == 0) {
+        if (config.pin) {
+            pinToCpu(0);
+        }
+        SharedMemoryRing producer = SharedMemoryRing::attach(ring.fd(), Role::Producer);
+        for (std::uint64_t i = 0; i < config.items; i++) {
+            std::optional<std::span<std::byte>> record;
+            retry([&]() { return (record = producer.reserve(8 + i % 57)).has_value(); });
+            std::memcpy(record->data(), &i, sizeof(i));
+            std::memset(record->data() + sizeof(i), (int) (i & 0xff), record->size() - sizeof(i));
+            producer.commit();
+        }
+        ::_exit(0);
+    }
+
+    if (config.pin) {
+        pinToCpu(1);
+    }
+    bool inOrder = true;
+    for (std::uint64_t i = 0; i < config.items; i++) {
+        std::optional<std::span<const std::byte>> record;
+        retry([&]() { return (record = ring.peek()).has_value(); });
+        std::uint64_t v;
+        std::memcpy(&v, record->data(), sizeof(v));
+        inOrder &= v == i && record->size() == 8 + i % 57 &&
+                   (record->size() == 8 || record->back() == (std::byte) (i & 0xff));
+        ring.release();
+    }
+    int status;
+    ::waitpid(child, &status, 0);
+    auto end = std::chrono::steady_clock::now();
+
+    QueueResult result;
+    result.seconds = std::chrono::duration<double>(end - begin).count();
+    result.correct = inOrder && WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+                     !ring.peek() && ring.peer() == SharedMemoryRing::PeerState::Dead;
+    return result;
+}
+
+/* Blocking push/pop for the multi-producer queues */
+void push(BoundedMPMCQueue<std::uint64_t>& queue, std::uint64_t v) {
+    queue.enqueue(v);
+}
+
+std::uint64_t pop(BoundedMPMCQueue<std::uint64_t>& queue) {
+    return queue.dequeue();
+}
+
+void push(UnboundedQueue<std::uint64_t>& queue, std::uint64_t v) {
+    queue.enqueue(v);
+}
+
+std::uint64_t pop(UnboundedQueue<std::uint64_t>& queue) {
+    std::uint64_t v;
+    retry([&]() { return queue.dequeue(v); });
+    return v;
+}
+
+void push(LockFreeQueue<std::uint64_t>& queue, std::uint64_t v) {
+    queue.enqueue(v);
+}
+
+std::uint64_t pop(LockFreeQueue<std::uint64_t>& queue) {
+    std::uint64_t v;
+    retry([&]() { return queue.dequeue(v); });
+    return v;
+}
+
+void push(SegmentedFAAQueue<std::uint64_t>& queue, std::uint64_t v) {
+    queue.enqueue(v);
+}
+
+std::uint64_t pop(SegmentedFAAQueue<std::uint64_t>& queue) {
+    std::uint64_t v;
+    retry([&]() { return queue.dequeue(v); });
+    return v;
+}
+
+template <typename Q, typename W>
+void push(BlockingQueue<Q, W>& queue, std::uint64_t v) {
+    queue.push(v);
+}
+
+template <typename Q, typename W>
+std::uint64_t pop(BlockingQueue<Q, W>& queue) {
+    return queue.pop();
+}
+
+/* Producer p sends (p << PRODUCER_SHIFT) | i for its i = 0, 1, ...; each
+ * consumer checks that it sees every producer's values in increasing order,
+ * and together they must see each value exactly once (count and sum).
+ * Once the producers are done, one STOP per consumer ends the run. */
+constexpr unsigned PRODUCER_SHIFT = 40;
+constexpr std::uint64_t STOP = ~0ull;
+
+/* WithCapacity: build the queue with config.capacity, if it takes one */
+template <typename Q, bool WithCapacity = std::is_constructible_v<Q, std::size_t>>
+QueueResult mpmc(const QueueConfig& config) {
+    std::unique_ptr<Q> queue;
+    if constexpr (WithCapacity) {
+        queue = std::make_unique<Q>(config.capacity);
+    } else {
+        queue = std::make_unique<Q>();
+    }
+
+    struct alignas(CACHE_LINE_SIZE) PerConsumer {
+        std::uint64_t count{0};
+        std::uint64_t sum{0};
+        bool inOrder{true};
+    };
+    std::vector<PerConsumer> perConsumer(config.consumers);
+    std::atomic_bool start{false};
+
+    std::vector<std::thread> producers;
+    for (unsigned p = 0; p < config.producers; p++) {
+        producers.emplace_back([&, p]() {
+            if (config.pin) {
+                pinToCpu(p);
+            }
+            while (!start.load(std::memory_order_acquire)) {}
+            std::uint64_t n = config.items / config.producers + (p < config.items % config.producers);
+            for (std::uint64_t i = 0; i < n; i++) {
+                push(*queue, ((std::uint64_t) p << PRODUCER_SHIFT) | i);
+            }
+        });
+    }
+    std::vector<std::thread> consumers;
+    for (unsigned c = 0; c < config.consumers; c++) {
+        consumers.emplace_back([&, c]() {
+            if (config.pin) {
+                pinToCpu(config.producers + c);
+            }
+            PerConsumer& me = perConsumer[c];
+            std::vector<std::uint64_t> next(config.producers, 0);  // lowest value still expected
+            while (!start.load(std::memory_order_acquire)) {}
+            for (std::uint64_t v = pop(*queue); v != STOP; v = pop(*queue)) {
+                std::uint64_t p = v >> PRODUCER_SHIFT;
+                std::uint64_t i = v & ((1ull << PRODUCER_SHIFT) - 1);
+                me.inOrder &= p < config.producers && i >= next[p];
+                next[p] = i + 1;
+                me.count++;
+                me.sum += i;
+            }
+        });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    for (std::thread& t : producers) {
+        t.join();
+    }
+    for (unsigned c = 0; c < config.consumers; c++) {
+        push(*queue, STOP);
+    }
+    for (std::thread& t : consumers) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    std::uint64_t expectedSum = 0;
+    for (unsigned p = 0; p < config.producers; p++) {
+        std::uint64_t n = config.items / config.producers + (p < config.items % config.producers);
+        expectedSum += n * (n - 1) / 2;
+    }
+    std::uint64_t count = 0;
+    std::uint64_t sum = 0;
+    bool inOrder = true;
+    for (const PerConsumer& c : perConsumer) {
+        count += c.count;
+        sum += c.sum;
+        inOrder &= c.inOrder;
+    }
+
+    QueueResult result;
+    result.seconds = std::chrono::duration<double>(end - begin).count();
+    result.correct = inOrder && count == config.items && sum == expectedSum;
+    return result;
+}
+
+struct Entry {
+    const char* name;
+    bool spsc;  // always one producer and one consumer, ignores the -t sweep
+    QueueResult (*run)(const QueueConfig&);
+};
+
+const Entry ENTRIES[] = {
+    {"SPSCqueue",             true,  spsc<std::uint64_t>},
+    {"SPSCqueue<unique_ptr>", true,  spsc<std::unique_ptr<std::uint64_t>>},
+    {"MinSPSCQueue",          true,  minSpsc<false>},
+    {"MinSPSCQueue/bulk",     true,  minSpsc<true>},
+    {"SharedMemoryRing",      true,  sharedMemory},
+    {"BoundedMPMCQueue",      false, mpmc<BoundedMPMCQueue<std::uint64_t>>},
+    {"UnboundedQueue",        false, mpmc<UnboundedQueue<std::uint64_t>, false>},
+    {"UnboundedQueue/fixed",  false, mpmc<UnboundedQueue<std::uint64_t>, true>},
+    {"LockFreeQueue",         false, mpmc<LockFreeQueue<std::uint64_t>>},
+    {"SegmentedFAAQueue",     false, mpmc<SegmentedFAAQueue<std::uint64_t>>},
+    {"BoundedMPMCQueue+SpinYieldWait", false, mpmc<BlockingQueue<BoundedMPMCQueue<std::uint64_t>, SpinYieldWait>>},
+    {"BoundedMPMCQueue+ParkWait",      false, mpmc<BlockingQueue<BoundedMPMCQueue<std::uint64_t>, ParkWait>>},
+    {"BoundedMPMCQueue+EventfdWait",   false, mpmc<BlockingQueue<BoundedMPMCQueue<std::uint64_t>, EventfdWait>>},
+    {"LockFreeQueue+ParkWait",         false, mpmc<BlockingQueue<LockFreeQueue<std::uint64_t>, ParkWait>>},
+};
+
+std::string getUsageString() {
+    return std::string("USAGE:\n") +
+           "\t'./queue_bench [-t THREADS] [-n ITEMS] [-c CAPACITY] [-b BATCH] [-a 0|1]'\n" +
+           "\t - THREADS is a comma-separated sweep of producers (and as many consumers)\n" +
+           "\t   for the multi-producer queues (default 1,2,4,8,16,32)\n" +
+           "\t - ITEMS is the number of values moved through each queue (default 4194304)\n" +
+           "\t - CAPACITY is the ring size of the bounded queues, and the node count\n" +
+           "\t   of UnboundedQueue/fixed, and /64 the byte size of SharedMemoryRing\n" +
+           "\t   (default 1024)\n" +
+           "\t - BATCH is the number of elements per bulk operation (default 64)\n" +
+           "\t - '-a 1' pins thread i to CPU i\n";
+}
+
+int main(int argc, char** argv) {
+    QueueConfig config;
+    std::vector<unsigned> threads{1, 2, 4, 8, 16, 32};
+
+    if (argc % 2 == 0) {
+        std::cerr << getUsageString();
+        return -1;
+    }
+    for (int i = 1; i < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i+1];
+        if (flag == "-t") {
+            threads = parseThreadList(value);
+            if (threads.empty()) {
+                std::cerr << "THREADS must be at least 1\n" << getUsageString();
+                return -1;
+            }
+        } else if (flag == "-n") {
+            config.items = std::stoull(value);
+        } else if (flag == "-c") {
+            config.capacity = std::stoul(value);
+        } else if (flag == "-b") {
+            config.batch = std::stoul(value);
+        } else if (flag == "-a") {
+            config.pin = std::stoul(value) != 0;
+        } else {
+            std::cerr << getUsageString();
+            return -1;
+        }
+    }
+
+    bool allCorrect = true;
+    std::printf("queue,producers,consumers,items,seconds,throughput,correct\n");
+    for (const Entry& entry : ENTRIES) {
+        for (unsigned t : entry.spsc ? std::vector<unsigned>{1} : threads) {
+            config.producers = t;
+            config.consumers = t;
+            QueueResult r = entry.run(config);
+            std::printf("%s,%u,%u,%llu,%.4f,%.0f,%d\n",
+                        entry.name,
+                        config.producers,
+                        config.consumers,
+                        (unsigned long long) config.items,
+                        r.seconds,
+                        config.items / r.seconds,
+                        r.correct ? 1 : 0);
+            std::fflush(stdout);
+            if (!r.correct) {
+                std::cerr << entry.name << ": items lost, duplicated or reordered with "
+                          << t << " producers" << std::endl;
+                allCorrect = false;
+            }
+        }
+    }
+
+    return allCorrect ? 0 : 1;
+}
@@ -1,42 +1,149 @@
-#include <memory>  // unique_ptr
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
 #include <atomic>
+#include <bit>        // bit_ceil
+#include <cstddef>
+#include <memory>     // unique_ptr, construct_at, destroy_at
+#include <new>        // launder
+#include <optional>
+#include <stdexcept>
+#include <utility>    // forward, move
+#include "CacheLine.hpp"
 
+/* Bounded single-producer single-consumer ring.
+ *
+ * head (next slot to read) and tail (next slot to write) only ever grow;
+ * the slot is index & mask, so the capacity is rounded up to a power of two.
+ * Each index lives on its own cache line next to its owner's cached copy of
+ * the OTHER index: the producer only re-reads head when its cached head says
+ * the ring is full, and the consumer only re-reads tail when its cached tail
+ * says it is empty. In steady state each side touches the other's line once
+ * per lap of the ring rather than once per element.
+ *
+ * Elements are constructed in place and moved out, so T may be move-only
+ * and need not be default-constructible. */
 template <typename T>
 class SPSCqueue
 {
 public:
-    SPSCqueue(int capacity)
-    : capacity_{capacity},
-      head_{0},
-      tail_{0}
-    {
-        ringBuffer_ = std::make_unique<T[]>(capacity);
+    using value_type = T;
+
+    explicit SPSCqueue(std::size_t capacity)
+    : mask_{std::bit_ceil(capacity) - 1},
+      ringBuffer_{std::make_unique<Cell[]>(mask_ + 1)}
+    {}
+
+    ~SPSCqueue() {
+        std::size_t tail = producer_.tail.load(std::memory_order_relaxed);
+        for (std::size_t head = consumer_.head.load(std::memory_order_relaxed); head != tail; head++) {
+            std::destroy_at(slot(head));
+        }
+    }
+
+    SPSCqueue(const SPSCqueue&) = delete;
+    SPSCqueue& operator=(const SPSCqueue&) = delete;
+
+    /* Producer only. Returns false if the queue is full. */
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        std::size_t tail = producer_.tail.load(std::memory_order_relaxed);
+        if (tail - producer_.cachedHead > mask_) {
+            producer_.cachedHead = consumer_.head.load(std::memory_order_acquire);
+            if (tail - producer_.cachedHead > mask_) {
+                return false;
+            }
+        }
+        std::construct_at(slot(tail), std::forward<Args>(args)...);
+        producer_.tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_enqueue(const T& v) {
+        return try_emplace(v);
+    }
+
+    bool try_enqueue(T&& v) {
+        return try_emplace(std::move(v));
+    }
+
+    /* Consumer only. Returns false if the queue is empty. */
+    bool try_dequeue(T& out) {
+        std::size_t head = consumer_.head.load(std::memory_order_relaxed);
+        if (!readable(head)) {
+            return false;
+        }
+        T* v = slot(head);
+        out = std::move(*v);
+        std::destroy_at(v);
+        consumer_.head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::optional<T> try_dequeue() {
+        std::size_t head = consumer_.head.load(std::memory_order_relaxed);
+        if (!readable(head)) {
+            return std::nullopt;
+        }
+        T* v = slot(head);
+        std::optional<T> result{std::move(*v)};
+        std::destroy_at(v);
+        consumer_.head.store(head + 1, std::memory_order_release);
+        return result;
     }
 
     void enqueue(T v) {
-        if (tail_.load(std::memory_order_seq_cst) - head.load(std::memory_order_seq_cst) == capacity_) {
-            throw std::exception("FullException");
+        if (!try_emplace(std::move(v))) {
+            throw std::runtime_error("enqueueing to full queue");
         }
-        int tail = tail_.load(std::memory_order_seq_cst);
-        ringBuffer_[tail] = v;
-        tail_.store((tail+1) % capacity_, std::memory_order_seq_cst);
-        return;
     }
 
     T dequeue() {
-        if (tail_.load(std::memory_order_seq_cst) == head.load(std::memory_order_seq_cst)) {
-            throw std::exception("EmptyException");
+        std::optional<T> v = try_dequeue();
+        if (!v) {
+            throw std::runtime_error("dequeueing from empty queue");
         }
+        return std::move(*v);
+    }
 
-        int head = head_.load(std::memory_order_seq_cst);
-        T v = ringBuffer_[head];
-        head_.store((head+1) % capacity_, std::memory_order_seq_cst);  // TODO: use relaxed, release, acquire instead
-        return v;
+    std::size_t capacity() const {
+        return mask_ + 1;
     }
 
 private:
-    int capacity_;
-    std::atomic_int head_;
-    std::atomic_int tail_;
-    std::unique_ptr<T[]> ringBuffer_;
+    struct Cell {
+        alignas(T) std::byte storage[sizeof(T)];
+    };
+
+    struct alignas(CACHE_LINE_SIZE) Producer {
+        std::atomic<std::size_t> tail{0};
+        std::size_t cachedHead{0};  // producer's last view of consumer_.head
+    };
+
+    struct alignas(CACHE_LINE_SIZE) Consumer {
+        std::atomic<std::size_t> head{0};
+        std::size_t cachedTail{0};  // consumer's last view of producer_.tail
+    };
+
+    T* slot(std::size_t index) {
+        return std::launder(reinterpret_cast<T*>(ringBuffer_[index & mask_].storage));
+    }
+
+    bool readable(std::size_t head) {
+        if (head == consumer_.cachedTail) {
+            consumer_.cachedTail = producer_.tail.load(std::memory_order_acquire);
+            if (head == consumer_.cachedTail) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // read-only after construction, on their own line
+    alignas(CACHE_LINE_SIZE) const std::size_t mask_;
+    const std::unique_ptr<Cell[]> ringBuffer_;
+    Producer producer_;
+    Consumer consumer_;
 };
+
+#endif
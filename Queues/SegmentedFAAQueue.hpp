@@ -0,0 +1,191 @@
+#ifndef SEGMENTED_FAA_QUEUE_HPP
+#define SEGMENTED_FAA_QUEUE_HPP
+
+#include <algorithm>  // min
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>     // construct_at, destroy_at
+#include <new>        // launder
+#include <optional>
+#include <utility>    // move
+#include "CacheLine.hpp"
+#include "HazardPointers.hpp"
+
+/* Unbounded MPMC queue of array segments linked like a Michael-Scott queue
+ * (after LCRQ and Ramalhete and Correia's FAAArrayQueue). Within a segment
+ * producers and consumers claim slots with fetch_add on enqIdx / deqIdx
+ * rather than CAS on a shared pointer, so under contention every thread
+ * still gets a slot per atomic operation instead of retrying. Only when a
+ * segment's SEGMENT_SIZE slots are used up does a producer append a new one
+ * (a CAS, once per SEGMENT_SIZE elements).
+ *
+ * The producer and consumer that drew the same index meet in the slot:
+ *
+ *   EMPTY -> FULL    the producer got there first, the consumer takes the value
+ *   EMPTY -> TAKEN   the consumer got there first and poisons the slot; the
+ *                    producer takes its value back and draws a new index
+ *
+ * Segments are reclaimed with hazard pointers (slot 0 holds the segment
+ * being worked on): the consumer that swings head past an exhausted segment
+ * retires it. */
+template <typename T>
+class SegmentedFAAQueue {
+public:
+    using value_type = T;
+
+    static constexpr std::size_t SEGMENT_SIZE = 1024;
+
+    explicit SegmentedFAAQueue(HazardPointers& domain = HazardPointers::global()) : hp{domain} {
+        Segment* first = new Segment;
+        head.store(first, std::memory_order_relaxed);
+        tail.store(first, std::memory_order_relaxed);
+    }
+
+    ~SegmentedFAAQueue() {
+        Segment* segment = head.load(std::memory_order_relaxed);
+        while (segment) {
+            std::size_t end = std::min(segment->enqIdx.load(std::memory_order_relaxed), SEGMENT_SIZE);
+            for (std::size_t i = segment->deqIdx.load(std::memory_order_relaxed); i < end; i++) {
+                if (segment->slots[i].state.load(std::memory_order_relaxed) == FULL) {
+                    std::destroy_at(segment->slots[i].value());
+                }
+            }
+            Segment* next = segment->next.load(std::memory_order_relaxed);
+            delete segment;
+            segment = next;
+        }
+    }
+
+    SegmentedFAAQueue(const SegmentedFAAQueue&) = delete;
+    SegmentedFAAQueue& operator=(const SegmentedFAAQueue&) = delete;
+
+    void enqueue(T v) {
+        while (true) {
+            Segment* last = hp.protect(0, tail);
+            std::size_t idx = last->enqIdx.fetch_add(1, std::memory_order_acq_rel);
+            if (idx < SEGMENT_SIZE) {
+                Slot& slot = last->slots[idx];
+                std::construct_at(slot.value(), std::move(v));
+                std::uint32_t expected = EMPTY;
+                if (slot.state.compare_exchange_strong(expected, FULL,
+                                                       std::memory_order_acq_rel,
+                                                       std::memory_order_relaxed)) {
+                    break;
+                }
+                // a consumer gave up on this slot, draw another
+                v = std::move(*slot.value());
+                std::destroy_at(slot.value());
+                continue;
+            }
+
+            // this segment is full
+            if (last != tail.load(std::memory_order_acquire)) {
+                continue;
+            }
+            Segment* next = last->next.load(std::memory_order_acquire);
+            if (next != nullptr) {
+                // help with another producer's append
+                tail.compare_exchange_strong(last, next,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed);
+                continue;
+            }
+            Segment* segment = new Segment;
+            std::construct_at(segment->slots[0].value(), std::move(v));
+            segment->slots[0].state.store(FULL, std::memory_order_relaxed);
+            segment->enqIdx.store(1, std::memory_order_relaxed);
+            if (last->next.compare_exchange_strong(next, segment,
+                                                   std::memory_order_release,
+                                                   std::memory_order_relaxed)) {
+                tail.compare_exchange_strong(last, segment,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed);
+                break;
+            }
+            // another producer appended first; use its segment
+            v = std::move(*segment->slots[0].value());
+            std::destroy_at(segment->slots[0].value());
+            delete segment;
+        }
+        hp.clear(0);
+    }
+
+    /* std::nullopt if the queue is empty */
+    std::optional<T> dequeue() {
+        std::optional<T> result;
+        while (true) {
+            Segment* first = hp.protect(0, head);
+            if (first->deqIdx.load(std::memory_order_acquire) >=
+                    first->enqIdx.load(std::memory_order_acquire) &&
+                first->next.load(std::memory_order_acquire) == nullptr) {
+                break;
+            }
+            std::size_t idx = first->deqIdx.fetch_add(1, std::memory_order_acq_rel);
+            if (idx < SEGMENT_SIZE) {
+                Slot& slot = first->slots[idx];
+                if (slot.state.exchange(TAKEN, std::memory_order_acq_rel) == FULL) {
+                    result.emplace(std::move(*slot.value()));
+                    std::destroy_at(slot.value());
+                    break;
+                }
+                continue;  // poisoned it before its producer arrived
+            }
+
+            // this segment is used up
+            Segment* next = first->next.load(std::memory_order_acquire);
+            if (next == nullptr) {
+                break;
+            }
+            // tail must not be left on a segment that is about to be retired
+            Segment* last = first;
+            tail.compare_exchange_strong(last, next,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed);
+            if (head.compare_exchange_strong(first, next,
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_relaxed)) {
+                hp.clear(0);
+                hp.retire(first);
+            }
+        }
+        hp.clear(0);
+        return result;
+    }
+
+    bool dequeue(T& out) {
+        std::optional<T> v = dequeue();
+        if (!v) {
+            return false;
+        }
+        out = std::move(*v);
+        return true;
+    }
+
+private:
+    static constexpr std::uint32_t EMPTY = 0;
+    static constexpr std::uint32_t FULL = 1;
+    static constexpr std::uint32_t TAKEN = 2;
+
+    struct Slot {
+        std::atomic<std::uint32_t> state{EMPTY};
+        alignas(T) std::byte storage[sizeof(T)];  // constructed while FULL
+
+        T* value() {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+
+    struct Segment {
+        alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> enqIdx{0};
+        alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> deqIdx{0};
+        alignas(CACHE_LINE_SIZE) std::atomic<Segment*> next{nullptr};
+        Slot slots[SEGMENT_SIZE];
+    };
+
+    HazardPointers& hp;
+    alignas(CACHE_LINE_SIZE) std::atomic<Segment*> head;
+    alignas(CACHE_LINE_SIZE) std::atomic<Segment*> tail;
+};
+
+#endif
@@ -0,0 +1,381 @@
+#ifndef SHARED_MEMORY_RING_HPP
+#define SHARED_MEMORY_RING_HPP
+
+#include <atomic>
+#include <bit>        // has_single_bit
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>    // memcpy
+#include <new>        // placement new
+#include <optional>
+#include <signal.h>   // kill
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>    // exchange
+#include <fcntl.h>    // O_* constants
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "CacheLine.hpp"
+
+/* Single-producer single-consumer ring of variable-length records in
+ * memory shared between two processes: a POSIX shared memory object
+ * (/dev/shm/<name>) or an anonymous memfd whose fd is handed to the other
+ * process (inherited across fork, or sent over a Unix socket).
+ *
+ * The mapping holds a Header and then the data area. Nothing in it is a
+ * pointer, since each process maps it at its own address: head and tail
+ * are byte counts that only grow, and 'pos & (capacity - 1)' is an offset
+ * into the data area.
+ *
+ * Each record is an 8-byte frame header (payload length, flags) followed by
+ * the payload, padded to 8 bytes. A record never wraps: if it does not fit
+ * before the end of the area the producer first writes a PAD frame over
+ * the rest, which the consumer skips. reserve()/commit() and
+ * peek()/release() hand out the record's bytes in place, so a payload is
+ * written once by the producer and read once by the consumer; try_push and
+ * try_pop copy trivially copyable values in and out of single records.
+ *
+ * Each side records its pid in the header when it attaches and a 'closed'
+ * flag when it is destroyed, so peer() tells a live peer from one that
+ * left cleanly (Closed) or died without closing (Dead: its pid is gone). */
+class SharedMemoryRing {
+public:
+    static constexpr std::uint64_t MAGIC = 0x31474e4952435053;  // "SPCRING1"
+    static constexpr std::uint32_t VERSION = 1;
+
+    enum class Role { Producer, Consumer };
+    enum class PeerState { Absent, Alive, Closed, Dead };
+
+    /* capacity: bytes of the data area, a power of two of at least 64 */
+    static SharedMemoryRing create(const std::string& name, std::size_t capacity, Role role) {
+        int fd = ::shm_open(shmName(name).c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+        }
+        return SharedMemoryRing{fd, true, capacity, role};
+    }
+
+    static SharedMemoryRing createAnonymous(std::size_t capacity, Role role) {
+        int fd = ::memfd_create("SharedMemoryRing", MFD_CLOEXEC);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "memfd_create");
+        }
+        return SharedMemoryRing{fd, true, capacity, role};
+    }
+
+    static SharedMemoryRing attach(const std::string& name, Role role) {
+        int fd = ::shm_open(shmName(name).c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+        }
+        return SharedMemoryRing{fd, true, role};
+    }
+
+    /* fd stays the caller's */
+    static SharedMemoryRing attach(int fd, Role role) {
+        return SharedMemoryRing{fd, false, role};
+    }
+
+    /* Removes the name; mappings stay valid until both sides are gone */
+    static void unlink(const std::string& name) {
+        ::shm_unlink(shmName(name).c_str());
+    }
+
+    SharedMemoryRing(SharedMemoryRing&& other) noexcept
+    : fd_{std::exchange(other.fd_, -1)},
+      ownsFd{other.ownsFd},
+      role{other.role},
+      header{std::exchange(other.header, nullptr)},
+      data{other.data},
+      mask{other.mask},
+      mappedSize{other.mappedSize},
+      cachedIndex{other.cachedIndex},
+      pending{other.pending} {}
+
+    SharedMemoryRing& operator=(SharedMemoryRing&&) = delete;
+    SharedMemoryRing(const SharedMemoryRing&) = delete;
+    SharedMemoryRing& operator=(const SharedMemoryRing&) = delete;
+
+    ~SharedMemoryRing() {
+        if (header) {
+            mine().closed.store(1, std::memory_order_release);
+            ::munmap(header, mappedSize);
+        }
+        if (ownsFd && fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    int fd() const {
+        return fd_;
+    }
+
+    std::size_t capacity() const {
+        return mask + 1;
+    }
+
+    /* Largest payload that always fits eventually, wherever the ring wraps */
+    std::size_t maxRecordSize() const {
+        return capacity() / 2 - FRAME;
+    }
+
+    /* Producer: size bytes of the ring to write the next record into, or
+     * nullopt while the ring is too full. Nothing is visible to the
+     * consumer until commit(). */
+    std::optional<std::span<std::byte>> reserve(std::size_t size) {
+        if (size > maxRecordSize()) {
+            throw std::length_error("SharedMemoryRing: record larger than maxRecordSize()");
+        }
+        std::uint64_t tail = header->producer.index.load(std::memory_order_relaxed);
+        std::size_t offset = tail & mask;
+        std::size_t contiguous = capacity() - offset;
+        std::size_t total = frameSize(size);
+        std::size_t pad = total > contiguous ? contiguous : 0;
+        if (tail + pad + total - cachedIndex > capacity()) {
+            cachedIndex = header->consumer.index.load(std::memory_order_acquire);
+            if (tail + pad + total - cachedIndex > capacity()) {
+                return std::nullopt;
+            }
+        }
+        pending = Pending{pad, size};
+        return std::span<std::byte>{data + (pad ? 0 : offset) + FRAME, size};
+    }
+
+    /* Producer: publishes the last reserve()d record */
+    void commit() {
+        std::uint64_t tail = header->producer.index.load(std::memory_order_relaxed);
+        if (pending.pad) {
+            writeFrame(tail & mask, pending.pad - FRAME, PAD);
+            tail += pending.pad;
+        }
+        writeFrame(tail & mask, pending.size, 0);
+        header->producer.index.store(tail + frameSize(pending.size), std::memory_order_release);
+        pending = Pending{};
+    }
+
+    bool try_write(std::span<const std::byte> record) {
+        std::optional<std::span<std::byte>> out = reserve(record.size());
+        if (!out) {
+            return false;
+        }
+        std::memcpy(out->data(), record.data(), record.size());
+        commit();
+        return true;
+    }
+
+    template <typename T>
+    requires std::is_trivially_copyable_v<T>
+    bool try_push(const T& v) {
+        return try_write(std::as_bytes(std::span<const T, 1>{&v, 1}));
+    }
+
+    /* Consumer: the next record, or nullopt if there is none. It stays
+     * valid, and in the ring, until release(). */
+    std::optional<std::span<const std::byte>> peek() {
+        std::uint64_t head = header->consumer.index.load(std::memory_order_relaxed);
+        while (true) {
+            if (head == cachedIndex) {
+                cachedIndex = header->producer.index.load(std::memory_order_acquire);
+                if (head == cachedIndex) {
+                    return std::nullopt;
+                }
+            }
+            Frame frame;
+            std::memcpy(&frame, data + (head & mask), FRAME);
+            if (frame.flags & PAD) {
+                head += FRAME + frame.length;
+                header->consumer.index.store(head, std::memory_order_release);
+                continue;
+            }
+            return std::span<const std::byte>{data + (head & mask) + FRAME, frame.length};
+        }
+    }
+
+    /* Consumer: hands the record of the last peek() back to the producer */
+    void release() {
+        std::uint64_t head = header->consumer.index.load(std::memory_order_relaxed);
+        Frame frame;
+        std::memcpy(&frame, data + (head & mask), FRAME);
+        header->consumer.index.store(head + frameSize(frame.length), std::memory_order_release);
+    }
+
+    /* false if there is no record; throws if the next one is not a T */
+    template <typename T>
+    requires std::is_trivially_copyable_v<T>
+    bool try_pop(T& out) {
+        std::optional<std::span<const std::byte>> record = peek();
+        if (!record) {
+            return false;
+        }
+        if (record->size() != sizeof(T)) {
+            throw std::runtime_error("SharedMemoryRing: record size does not match the type popped");
+        }
+        std::memcpy(&out, record->data(), sizeof(T));
+        release();
+        return true;
+    }
+
+    /* The other side: never attached, attached and running, gone after
+     * closing its end, or gone without closing it (crashed or killed) */
+    PeerState peer() const {
+        const Side& other = role == Role::Producer ? header->consumer : header->producer;
+        pid_t pid = other.pid.load(std::memory_order_acquire);
+        if (pid == 0) {
+            return PeerState::Absent;
+        }
+        if (other.closed.load(std::memory_order_acquire)) {
+            return PeerState::Closed;
+        }
+        if (::kill(pid, 0) < 0 && errno == ESRCH) {
+            return PeerState::Dead;
+        }
+        return PeerState::Alive;
+    }
+
+private:
+    static constexpr std::size_t FRAME = 8;
+    static constexpr std::uint32_t PAD = 1;
+
+    struct Frame {
+        std::uint32_t length;  // of the payload
+        std::uint32_t flags;
+    };
+
+    // one per role, on its own line: index is the producer's tail or the
+    // consumer's head
+    struct alignas(CACHE_LINE_SIZE) Side {
+        std::atomic<std::uint64_t> index{0};
+        std::atomic<pid_t> pid{0};
+        std::atomic<std::uint32_t> closed{0};
+    };
+
+    struct Header {
+        std::atomic<std::uint64_t> magic;  // stored last by the creator
+        std::uint32_t version;
+        std::uint32_t headerSize;
+        std::uint64_t capacity;
+        Side producer;
+        Side consumer;
+    };
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free &&
+                  std::atomic<pid_t>::is_always_lock_free,
+                  "atomics in shared memory must not hide a lock");
+
+    struct Pending {
+        std::size_t pad{0};  // bytes of PAD frame before the record
+        std::size_t size{0};
+    };
+
+    /* Creator: size the object and write a fresh header */
+    SharedMemoryRing(int fd, bool ownsFd, std::size_t capacity, Role role)
+    : fd_{fd}, ownsFd{ownsFd}, role{role} {
+        if (capacity < 64 || !std::has_single_bit(capacity)) {
+            fail(std::invalid_argument("SharedMemoryRing: capacity must be a power of two >= 64"));
+        }
+        if (::ftruncate(fd, sizeof(Header) + capacity) < 0) {
+            fail(std::system_error(errno, std::generic_category(), "ftruncate"));
+        }
+        map(sizeof(Header) + capacity);
+        header->version = VERSION;
+        header->headerSize = sizeof(Header);
+        header->capacity = capacity;
+        new (&header->producer) Side;
+        new (&header->consumer) Side;
+        header->magic.store(MAGIC, std::memory_order_release);
+        setup(capacity);
+    }
+
+    /* Attacher: check that the object holds a compatible ring */
+    SharedMemoryRing(int fd, bool ownsFd, Role role) : fd_{fd}, ownsFd{ownsFd}, role{role} {
+        struct stat st;
+        if (::fstat(fd, &st) < 0) {
+            fail(std::system_error(errno, std::generic_category(), "fstat"));
+        }
+        if ((std::size_t) st.st_size < sizeof(Header)) {
+            fail(std::runtime_error("SharedMemoryRing: object too small for a ring header"));
+        }
+        map(st.st_size);
+        if (header->magic.load(std::memory_order_acquire) != MAGIC ||
+            header->version != VERSION ||
+            header->headerSize != sizeof(Header) ||
+            sizeof(Header) + header->capacity != mappedSize) {
+            fail(std::runtime_error("SharedMemoryRing: not a ring of this version"));
+        }
+        setup(header->capacity);
+    }
+
+    void map(std::size_t size) {
+        void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED) {
+            fail(std::system_error(errno, std::generic_category(), "mmap"));
+        }
+        header = static_cast<Header*>(p);
+        mappedSize = size;
+    }
+
+    /* Claims this process's side of the ring */
+    void setup(std::size_t capacity) {
+        data = reinterpret_cast<std::byte*>(header) + sizeof(Header);
+        mask = capacity - 1;
+        Side& me = mine();
+        pid_t previous = me.pid.load(std::memory_order_acquire);
+        if (previous != 0 && !me.closed.load(std::memory_order_acquire) &&
+            previous != ::getpid() && ::kill(previous, 0) == 0) {
+            fail(std::runtime_error(role == Role::Producer ? "SharedMemoryRing: producer already attached"
+                                                           : "SharedMemoryRing: consumer already attached"));
+        }
+        me.closed.store(0, std::memory_order_relaxed);
+        me.pid.store(::getpid(), std::memory_order_release);
+        const Side& other = role == Role::Producer ? header->consumer : header->producer;
+        cachedIndex = other.index.load(std::memory_order_acquire);
+    }
+
+    /* Undoes what the constructor has done so far, then throws */
+    template <typename E>
+    [[noreturn]] void fail(const E& error) {
+        if (header) {
+            ::munmap(header, mappedSize);
+        }
+        if (ownsFd) {
+            ::close(fd_);
+        }
+        throw error;
+    }
+
+    Side& mine() {
+        return role == Role::Producer ? header->producer : header->consumer;
+    }
+
+    void writeFrame(std::size_t offset, std::size_t length, std::uint32_t flags) {
+        Frame frame{(std::uint32_t) length, flags};
+        std::memcpy(data + offset, &frame, FRAME);
+    }
+
+    static std::size_t frameSize(std::size_t payload) {
+        return (FRAME + payload + 7) & ~(std::size_t) 7;
+    }
+
+    static std::string shmName(const std::string& name) {
+        return name.starts_with("/") ? name : "/" + name;
+    }
+
+    int fd_;
+    bool ownsFd;
+    Role role;
+    Header* header{nullptr};
+    std::byte* data{nullptr};
+    std::size_t mask{0};
+    std::size_t mappedSize{0};
+    // this process's copy of the other side's index: the consumer's head
+    // for the producer, the producer's tail for the consumer
+    std::uint64_t cachedIndex{0};
+    Pending pending;
+};
+
+#endif
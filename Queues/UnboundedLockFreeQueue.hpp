@@ -2,69 +2,134 @@
 #define UNBOUNDED_LOCK_FREE_QUEUE_HPP
 
 #include <atomic>
-#include <memory>
+#include <memory>     // construct_at, destroy_at
+#include <new>        // launder
+#include <optional>
+#include <utility>    // move
+#include "CacheLine.hpp"
+#include "HazardPointers.hpp"
 
+/* Michael-Scott queue on raw node pointers. head points at a sentinel, the
+ * first element is head->next; tail is the last node or, while an enqueue
+ * is half done, the one before it, and any thread that sees it lag swings
+ * it forward.
+ *
+ * Nodes are reclaimed with hazard pointers: every node a thread dereferences
+ * is protected first (slot 0: head or tail, slot 1: head->next), and the old
+ * sentinel is retired rather than deleted when head moves past it. So the
+ * only allocation per element is its node, and a node is only read while
+ * nobody can free it.
+ *
+ * The dequeuer that wins the CAS on head moves the value out of the new
+ * sentinel AFTER the CAS (its hazard pointer keeps the node alive), so T only
+ * needs to be movable. */
 template <typename T>
-class Node {
+class LockFreeQueue {
 public:
-    Node (T& v) : val{v} {
-        next.store(nullptr);
-    }
-
-    T val;
-    std::atomic<std::shared_ptr<Node<T>> next;
-};
+    using value_type = T;
 
+    explicit LockFreeQueue(HazardPointers& domain = HazardPointers::global()) : hp{domain} {
+        Node* sentinel = new Node;
+        head.store(sentinel, std::memory_order_relaxed);
+        tail.store(sentinel, std::memory_order_relaxed);
+    }
 
-template <typename T>
-class LockFreeQueue {
-public:
-    LockFreeQueue() {
-        head.store(std::make_shared<Node<T>(T()));  // sentinel
+    ~LockFreeQueue() {
+        Node* node = head.load(std::memory_order_relaxed);
+        Node* next = node->next.load(std::memory_order_relaxed);
+        delete node;  // the sentinel holds no value
+        for (node = next; node; node = next) {
+            next = node->next.load(std::memory_order_relaxed);
+            std::destroy_at(node->value());
+            delete node;
+        }
     }
 
-    void enqueue(T& v) {
-        std::shared_ptr<Node<T>> node = std::make_shared<Node<T>>(v);
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    void enqueue(T v) {
+        Node* node = new Node;
+        std::construct_at(node->value(), std::move(v));
         while (true) {
-            std::shared_ptr<Node<T>> last = tail.load();
-            std::shared_ptr<Node<T>> next = last->next.load();
-            if (last == tail.load()) {
-                if (next == nullptr) {
-                    if (last->next.compare_exchange_strong(next, node)) {
-                        tail.compare_exchange_strong(last, node);
-                        return;
-                    }
-                } else {
-                    tail.compare_exchange_strong(last, next);  // help with another thread's incomplete enqueue
+            Node* last = hp.protect(0, tail);
+            Node* next = last->next.load(std::memory_order_acquire);
+            if (last != tail.load(std::memory_order_acquire)) {
+                continue;
+            }
+            if (next == nullptr) {
+                if (last->next.compare_exchange_weak(next, node,
+                                                     std::memory_order_release,
+                                                     std::memory_order_relaxed)) {
+                    tail.compare_exchange_strong(last, node,
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed);
+                    break;
                 }
+            } else {
+                // help with another thread's incomplete enqueue
+                tail.compare_exchange_weak(last, next,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed);
             }
         }
+        hp.clear(0);
     }
 
-    std::shared_ptr<T> dequeue() {
+    /* std::nullopt if the queue is empty */
+    std::optional<T> dequeue() {
+        std::optional<T> result;
         while (true) {
-            std::shared_ptr<Node<T>> first = head.load();
-            std::shared_ptr<Node<T>> last = tail.load();
-            std::shared_ptr<Node<T>> next = first->next.load();
-
-            if (first == head.load()) {
-                if (first == last) {
-                    if (next == nullptr) {
-                        return nullptr;
-                    }
-                    tail.compare_exchange_strong(last, next);
-                }
-            } else {
-                std::shared_ptr<T> val = std::make_shared<T>(next.val);
-                if (head.compare_exchange_strong(first, next)) {
-                    return val;
+            Node* first = hp.protect(0, head);
+            Node* last = tail.load(std::memory_order_acquire);
+            Node* next = hp.protect(1, first->next);
+            if (first != head.load(std::memory_order_acquire)) {
+                continue;  // next may already be gone
+            }
+            if (first == last) {
+                if (next == nullptr) {
+                    break;
                 }
+                tail.compare_exchange_weak(last, next,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed);
+            } else if (head.compare_exchange_weak(first, next,
+                                                  std::memory_order_acq_rel,
+                                                  std::memory_order_relaxed)) {
+                // next is the new sentinel; only we touch its value
+                result.emplace(std::move(*next->value()));
+                std::destroy_at(next->value());
+                hp.clear();
+                hp.retire(first);
+                return result;
             }
         }
+        hp.clear();
+        return result;
+    }
+
+    bool dequeue(T& out) {
+        std::optional<T> v = dequeue();
+        if (!v) {
+            return false;
+        }
+        out = std::move(*v);
+        return true;
     }
 
 private:
-    std::atomic<std::shared_ptr<Node<T>> head, tail;
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        alignas(T) std::byte storage[sizeof(T)];  // constructed while the node is an element
+
+        T* value() {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+
+    HazardPointers& hp;
+    alignas(CACHE_LINE_SIZE) std::atomic<Node*> head;
+    alignas(CACHE_LINE_SIZE) std::atomic<Node*> tail;
 };
 
 #endif
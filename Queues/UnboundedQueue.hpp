@@ -1,44 +1,157 @@
 #ifndef UNBOUNDED_QUEUE_HPP
 #define UNBOUNDED_QUEUE_HPP
 
+#include <atomic>
+#include <cstddef>
+#include <memory>     // construct_at, destroy_at
 #include <mutex>
-#include <memory>
+#include <new>        // launder
+#include <optional>
+#include <thread>     // yield
+#include <utility>    // forward, move
+#include "Backoff.hpp"  // cpuRelax
+#include "CacheLine.hpp"
+#include "NodePool.hpp"
 
+/* Two-lock queue: enqueuers only touch tail, dequeuers only head, so one of
+ * each can work at the same time. head always points at a sentinel; the
+ * first element is head->next. When the queue is empty head == tail, and
+ * the enqueuer's write of tail->next races the dequeuer's read of
+ * head->next, hence 'next' is atomic.
+ *
+ * Nodes are intrusive (the value lives in the node) and come from the
+ * queue's own NodePool, so neither side calls the global allocator in the
+ * steady state, and a node is taken and returned outside the locks. The
+ * value is moved out under the dequeue lock, since once it is released the
+ * node becomes the sentinel that the next dequeuer frees.
+ *
+ * Built with a capacity, the queue allocates capacity + 1 nodes (one for the
+ * sentinel) up front and never again: try_enqueue fails while they are all
+ * in use, and enqueue waits (spin, then yield). Without one it grows by
+ * NodePool slabs and enqueue never waits. A thread that stops using a fixed
+ * queue keeps the few nodes in its pool cache until its ThreadIndex is
+ * reused, so the capacity left to the other threads can be that much lower. */
 template <typename T>
-class Node {
+class UnboundedQueue {
 public:
-    Node(T& v) : val{v} {}
+    using value_type = T;
 
-    T val;
-    std::shared_ptr<T> next{nullptr};
-};
+    static constexpr unsigned SPIN_LIMIT = 1024;  // cpuRelax()es before a blocked enqueuer yields
 
-template <typename T>
-class UnboundedQueue {
-public:
-    void enqueue(T& v) {
+    UnboundedQueue() : pool{} {
+        init();
+    }
+
+    explicit UnboundedQueue(std::size_t capacity) : pool{capacity + 1, false} {
+        init();
+    }
+
+    ~UnboundedQueue() {
+        Node* node = head;
+        Node* next = node->next.load(std::memory_order_relaxed);
+        free(node);  // the sentinel holds no value
+        for (node = next; node; node = next) {
+            next = node->next.load(std::memory_order_relaxed);
+            std::destroy_at(node->value());
+            free(node);
+        }
+    }
+
+    UnboundedQueue(const UnboundedQueue&) = delete;
+    UnboundedQueue& operator=(const UnboundedQueue&) = delete;
+
+    /* false only if the queue has a capacity and it is reached */
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        Node* node = pool.allocate();
+        if (!node) {
+            return false;
+        }
+        std::construct_at(node);
+        try {
+            std::construct_at(node->value(), std::forward<Args>(args)...);
+        } catch (...) {
+            free(node);  // else a fixed queue would lose the node for good
+            throw;
+        }
         std::lock_guard<std::mutex> enqLockGuard(enqLock);
-        std::shared_ptr<Node<T>> node = std::make_shared<Node<T>>(v);
-        tail->next = node;
+        tail->next.store(node, std::memory_order_release);
         tail = node;
+        return true;
     }
 
-    std::shared_ptr<T> dequeue(T& v) {
-        std::lock_guard<std::mutex> deqLockGuard(deqLock);
+    bool try_enqueue(const T& v) {
+        return try_emplace(v);
+    }
+
+    bool try_enqueue(T&& v) {
+        return try_emplace(std::move(v));
+    }
+
+    void enqueue(T v) {
+        for (unsigned i = 0; !try_emplace(std::move(v)); i++) {
+            if (i < SPIN_LIMIT) {
+                cpuRelax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
 
-        if (head->next == nullptr) {
-            return std::make_shared<T>(nullptr);
+    /* std::nullopt if the queue is empty */
+    std::optional<T> dequeue() {
+        Node* sentinel;
+        std::optional<T> result;
+        {
+            std::lock_guard<std::mutex> deqLockGuard(deqLock);
+            Node* first = head->next.load(std::memory_order_acquire);
+            if (first == nullptr) {
+                return result;
+            }
+            result.emplace(std::move(*first->value()));
+            std::destroy_at(first->value());
+            sentinel = head;
+            head = first;  // first becomes the new sentinel
         }
+        free(sentinel);
+        return result;
+    }
 
-        T res = head->next.val;
-        head = head->next;
-        return std::make_shared<T>(res);
+    bool dequeue(T& out) {
+        std::optional<T> v = dequeue();
+        if (!v) {
+            return false;
+        }
+        out = std::move(*v);
+        return true;
     }
 
 private:
-    std::mutex enqLock;
-    std::mutex deqLock;
-    std::shared_ptr<Node<T>> head, tail;
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        alignas(T) std::byte storage[sizeof(T)];  // constructed while the node is an element
+
+        T* value() {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+
+    void init() {
+        Node* sentinel = std::construct_at(pool.allocate());
+        head = sentinel;
+        tail = sentinel;
+    }
+
+    void free(Node* node) {
+        std::destroy_at(node);
+        pool.deallocate(node);
+    }
+
+    NodePool<Node> pool;
+    alignas(CACHE_LINE_SIZE) std::mutex enqLock;
+    Node* tail;
+    alignas(CACHE_LINE_SIZE) std::mutex deqLock;
+    Node* head;
 };
 
 #endif
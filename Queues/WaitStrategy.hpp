@@ -0,0 +1,217 @@
+#ifndef WAIT_STRATEGY_HPP
+#define WAIT_STRATEGY_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <concepts>
+#include <cstdint>
+#include <system_error>
+#include <thread>     // yield
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>   // read, write, close
+#include "Backoff.hpp"  // cpuRelax
+#include "CacheLine.hpp"
+
+/* How a thread waits for a queue to become non-empty (or non-full).
+ *
+ *   w.until(ready)  returns once ready() has returned true; ready is the
+ *                   attempted operation itself (e.g. a try_dequeue), so it
+ *                   may be called many times
+ *   w.notify()      called after every change that may make ready() true
+ *
+ * The strategies that put the waiter to sleep count their sleepers, and
+ * notify() only makes a system call when that count is non-zero, so a
+ * producer that nobody waits for pays one fence and one load. */
+template <typename W>
+concept WaitStrategyConcept = requires (W w, bool (*ready)()) {
+    w.until(ready);
+    w.notify();
+};
+
+/* Never leaves the CPU: lowest latency, for consumers on dedicated cores */
+class BusySpinWait {
+public:
+    template <typename Ready>
+    void until(Ready ready) {
+        while (!ready()) {
+            cpuRelax();
+        }
+    }
+
+    void notify() {}
+};
+
+static_assert(WaitStrategyConcept<BusySpinWait>);
+
+/* Spins SPIN_LIMIT times, then yields between attempts */
+class SpinYieldWait {
+public:
+    static constexpr unsigned SPIN_LIMIT = 1024;
+
+    template <typename Ready>
+    void until(Ready ready) {
+        for (unsigned i = 0; !ready(); i++) {
+            if (i < SPIN_LIMIT) {
+                cpuRelax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void notify() {}
+};
+
+static_assert(WaitStrategyConcept<SpinYieldWait>);
+
+/* Spins SPIN_LIMIT times, then sleeps in std::atomic::wait (a futex on
+ * Linux) on a sequence number that notify() bumps.
+ *
+ * A sleeper registers in 'sleepers' and then re-checks ready(); notify()
+ * follows the state change with a fence and then reads 'sleepers'. Either
+ * the sleeper sees the new state or notify() sees the sleeper, and since
+ * the sleeper read the sequence number before registering, a bump it
+ * missed makes wait() return at once. */
+class ParkWait {
+public:
+    static constexpr unsigned SPIN_LIMIT = 1024;
+
+    template <typename Ready>
+    void until(Ready ready) {
+        for (unsigned i = 0; i < SPIN_LIMIT; i++) {
+            if (ready()) {
+                return;
+            }
+            cpuRelax();
+        }
+        while (true) {
+            std::uint32_t seq = sequence.load(std::memory_order_acquire);
+            sleepers.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (ready()) {
+                sleepers.fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+            sequence.wait(seq, std::memory_order_acquire);
+            sleepers.fetch_sub(1, std::memory_order_relaxed);
+            if (ready()) {
+                return;
+            }
+        }
+    }
+
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        sequence.fetch_add(1, std::memory_order_release);
+        sequence.notify_one();  // one change, one element or slot
+    }
+
+private:
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> sequence{0};
+    std::atomic<std::uint32_t> sleepers{0};
+};
+
+static_assert(WaitStrategyConcept<ParkWait>);
+
+/* Spins SPIN_LIMIT times, then sleeps in poll() on an eventfd that
+ * notify() writes to. The eventfd can also be added to an epoll set, so
+ * an event loop can wait for the queue together with its sockets:
+ *
+ *     epoll_ctl(ep, EPOLL_CTL_ADD, wait.fd(), &event);  // EPOLLIN
+ *     while (running) {
+ *         wait.arm();                      // from here notify() writes
+ *         if (!queue.try_pop(v)) {
+ *             epoll_wait(ep, ...);
+ *             if (fd is wait.fd()) wait.consume();
+ *         }
+ *         wait.disarm();
+ *         ... drain the queue with try_pop ...
+ *     }
+ *
+ * The eventfd is a semaphore: every notify() that saw an armed waiter
+ * adds one token and every consume() takes one, so each notification
+ * wakes one waiter and unneeded tokens only cause spurious wakeups. */
+class EventfdWait {
+public:
+    static constexpr unsigned SPIN_LIMIT = 1024;
+
+    EventfdWait() : eventFd{::eventfd(0, EFD_SEMAPHORE | EFD_NONBLOCK | EFD_CLOEXEC)} {
+        if (eventFd < 0) {
+            throw std::system_error(errno, std::generic_category(), "eventfd");
+        }
+    }
+
+    ~EventfdWait() {
+        ::close(eventFd);
+    }
+
+    EventfdWait(const EventfdWait&) = delete;
+    EventfdWait& operator=(const EventfdWait&) = delete;
+
+    template <typename Ready>
+    void until(Ready ready) {
+        for (unsigned i = 0; i < SPIN_LIMIT; i++) {
+            if (ready()) {
+                return;
+            }
+            cpuRelax();
+        }
+        while (true) {
+            arm();
+            if (ready()) {
+                disarm();
+                return;
+            }
+            pollfd p{eventFd, POLLIN, 0};
+            ::poll(&p, 1, -1);
+            consume();
+            disarm();
+            if (ready()) {
+                return;
+            }
+        }
+    }
+
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (armed.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        std::uint64_t one = 1;
+        [[maybe_unused]] ssize_t n = ::write(eventFd, &one, sizeof(one));
+    }
+
+    /* For an event loop: readable whenever a notification is pending */
+    int fd() const {
+        return eventFd;
+    }
+
+    /* Announce that the caller is about to sleep on fd(); re-check the
+     * queue after this and before sleeping */
+    void arm() {
+        armed.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    void disarm() {
+        armed.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /* Take one pending notification, if any */
+    void consume() {
+        std::uint64_t token;
+        [[maybe_unused]] ssize_t n = ::read(eventFd, &token, sizeof(token));
+    }
+
+private:
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> armed{0};
+    const int eventFd;
+};
+
+static_assert(WaitStrategyConcept<EventfdWait>);
+
+#endif
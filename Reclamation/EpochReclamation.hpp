@@ -0,0 +1,201 @@
+#ifndef EPOCH_RECLAMATION_HPP
+#define EPOCH_RECLAMATION_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>   // unique_ptr
+#include <vector>
+#include "CacheLine.hpp"
+#include "ThreadIndex.hpp"
+
+/* Epoch-based reclamation (Fraser). Readers do not protect individual
+ * nodes; they only announce, on entering a read-side section, which global
+ * epoch they started in:
+ *
+ *     {
+ *         EpochReclamation::Guard guard;  // or Guard guard{domain}
+ *         ... traverse, unlink, domain.retire(node) ...
+ *     }
+ *
+ * A node retired while the global epoch is e can only still be referenced
+ * by threads that entered at e or earlier. The epoch only advances from e
+ * to e+1 once every thread inside a section has announced e, so when it
+ * reaches e+2 all of those threads have left and the node can be freed.
+ *
+ * Each thread (by ThreadIndex) keeps three limbo lists, one per epoch mod 3;
+ * a list is reused, and its contents freed in one batch, once it is two
+ * epochs old. Every BATCH retires a thread tries to advance the epoch.
+ * Entering and leaving a section costs one store and one fence on the
+ * thread's own announcement line, whatever the number of nodes touched.
+ *
+ * The catch: a thread that stays inside a section stops the epoch, and with
+ * it all reclamation. Sections must be short. */
+class EpochReclamation {
+    struct Record;
+
+public:
+    static constexpr unsigned MAX_THREADS = 256;
+    static constexpr std::size_t BATCH = 64;  // retires between attempts to advance the epoch
+
+    /* The domain the containers use unless given another one */
+    static EpochReclamation& global() {
+        static EpochReclamation domain;
+        return domain;
+    }
+
+    /* RAII read-side section. Nests: only the outermost guard announces. */
+    class Guard {
+    public:
+        explicit Guard(EpochReclamation& domain = global()) : domain{domain}, record{domain.enter()} {}
+
+        ~Guard() {
+            domain.exit(record);
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+    private:
+        EpochReclamation& domain;
+        Record& record;
+    };
+
+    EpochReclamation() = default;
+
+    ~EpochReclamation() {
+        for (unsigned i = 0; i < MAX_THREADS; i++) {
+            for (Limbo& limbo : records[i].limbo) {
+                free(records[i], limbo);
+            }
+        }
+    }
+
+    EpochReclamation(const EpochReclamation&) = delete;
+    EpochReclamation& operator=(const EpochReclamation&) = delete;
+
+    /* p must already be unreachable for threads that enter from now on */
+    template <typename T>
+    void retire(T* p) {
+        Record& me = mine();
+        // the unlink must be visible before we read which epoch it belongs to
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::uint64_t e = epoch.load(std::memory_order_relaxed);
+        Limbo& limbo = me.limbo[e % 3];
+        if (limbo.epoch != e) {
+            free(me, limbo);  // at most e-3, long safe
+            limbo.epoch = e;
+        }
+        limbo.retired.push_back(Retired{p, [](void* x) { delete static_cast<T*>(x); }});
+        me.pending.store(me.pending.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        if (++me.sinceAdvance >= BATCH) {
+            collect();
+        }
+    }
+
+    /* Tries to advance the epoch, then frees the caller's limbo lists that
+     * are two epochs old. retire() does this every BATCH retires; a thread
+     * that stops retiring can call it to hand back what it still holds. */
+    void collect() {
+        Record& me = mine();
+        me.sinceAdvance = 0;
+        tryAdvance();
+        std::uint64_t current = epoch.load(std::memory_order_acquire);
+        for (Limbo& l : me.limbo) {
+            if (l.epoch + 2 <= current) {
+                free(me, l);
+            }
+        }
+    }
+
+    /* Nodes retired and not freed yet, over all threads. Approximate while
+     * threads are retiring. */
+    std::size_t pending() const {
+        std::size_t sum = 0;
+        unsigned numRecords = activeRecords.load(std::memory_order_acquire);
+        for (unsigned i = 0; i < numRecords; i++) {
+            sum += records[i].pending.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    std::uint64_t currentEpoch() const {
+        return epoch.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr std::uint64_t QUIESCENT = ~0ull;
+
+    struct Retired {
+        void* ptr;
+        void (*deleter)(void*);
+    };
+
+    struct Limbo {
+        std::uint64_t epoch{0};
+        std::vector<Retired> retired;
+    };
+
+    struct Record {
+        // read by every thread that tries to advance the epoch
+        alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> announced{QUIESCENT};
+        // owner only, except 'pending' which pending() reads
+        alignas(CACHE_LINE_SIZE) unsigned nesting{0};
+        std::size_t sinceAdvance{0};
+        Limbo limbo[3];
+        std::atomic<std::size_t> pending{0};
+    };
+
+    Record& enter() {
+        Record& me = mine();
+        if (me.nesting++ == 0) {
+            me.announced.store(epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            // the announcement must be visible before any node is read
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+        return me;
+    }
+
+    void exit(Record& me) {
+        if (--me.nesting == 0) {
+            me.announced.store(QUIESCENT, std::memory_order_release);
+        }
+    }
+
+    /* e -> e+1 if every thread inside a section has announced e */
+    void tryAdvance() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::uint64_t e = epoch.load(std::memory_order_relaxed);
+        unsigned numRecords = activeRecords.load(std::memory_order_acquire);
+        for (unsigned i = 0; i < numRecords; i++) {
+            std::uint64_t announced = records[i].announced.load(std::memory_order_acquire);
+            if (announced != QUIESCENT && announced != e) {
+                return;
+            }
+        }
+        epoch.compare_exchange_strong(e, e + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    void free(Record& owner, Limbo& limbo) {
+        for (const Retired& r : limbo.retired) {
+            r.deleter(r.ptr);
+        }
+        owner.pending.store(owner.pending.load(std::memory_order_relaxed) - limbo.retired.size(),
+                            std::memory_order_relaxed);
+        limbo.retired.clear();  // keeps the capacity for the next batch
+    }
+
+    Record& mine() {
+        unsigned index = ThreadIndex::getBelow(MAX_THREADS, "EpochReclamation");
+        // tryAdvance() only looks at records below activeRecords
+        ThreadIndex::raiseHighWater(activeRecords, index, std::memory_order_seq_cst);
+        return records[index];
+    }
+
+    std::unique_ptr<Record[]> records{std::make_unique<Record[]>(MAX_THREADS)};
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> epoch{0};
+    std::atomic<unsigned> activeRecords{0};
+};
+
+#endif
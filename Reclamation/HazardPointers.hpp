@@ -0,0 +1,143 @@
+#ifndef HAZARD_POINTERS_HPP
+#define HAZARD_POINTERS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>   // unique_ptr
+#include <vector>
+#include "CacheLine.hpp"
+#include "ThreadIndex.hpp"
+
+/* Hazard pointers (Michael). Before dereferencing a shared node a thread
+ * publishes its address in one of its hazard slots and re-checks that the
+ * node is still reachable; a node that has been unlinked is retire()d
+ * instead of deleted, and only freed once no hazard slot holds it.
+ *
+ *     Node* first = hp.protect(0, head);  // safe to dereference now
+ *     ...
+ *     hp.retire(oldNode);                 // after unlinking it
+ *     hp.clear();
+ *
+ * Each thread (by ThreadIndex) owns SLOTS hazard slots and a list of the
+ * nodes it retired. Once that list reaches twice the number of hazard
+ * slots in use (and at least SCAN_THRESHOLD) the thread scans all slots and
+ * frees whatever is not protected, so at most O(threads * SLOTS) nodes per
+ * thread wait to be freed and the scan is amortized over as many retires.
+ *
+ * Retired nodes of a thread that exits stay with its index and are freed by
+ * the next thread that gets that index, or by the domain's destructor. */
+class HazardPointers {
+public:
+    static constexpr unsigned MAX_THREADS = 256;
+    static constexpr unsigned SLOTS = 2;
+    static constexpr std::size_t SCAN_THRESHOLD = 64;
+
+    /* The domain the containers use unless given another one */
+    static HazardPointers& global() {
+        static HazardPointers domain;
+        return domain;
+    }
+
+    HazardPointers() = default;
+
+    ~HazardPointers() {
+        for (unsigned i = 0; i < MAX_THREADS; i++) {
+            for (const Retired& r : records[i].retired) {
+                r.deleter(r.ptr);
+            }
+        }
+    }
+
+    HazardPointers(const HazardPointers&) = delete;
+    HazardPointers& operator=(const HazardPointers&) = delete;
+
+    /* Loads src into hazard slot 'slot' of the calling thread and returns it
+     * once the published value is known to still be current. */
+    template <typename T>
+    T* protect(unsigned slot, const std::atomic<T*>& src) {
+        std::atomic<void*>& hazard = mine().hazards[slot];
+        T* p = src.load(std::memory_order_relaxed);
+        while (true) {
+            // seq_cst store then load: the scanner must not miss a hazard
+            // that was published before the node was unlinked
+            hazard.store(p, std::memory_order_seq_cst);
+            T* current = src.load(std::memory_order_seq_cst);
+            if (current == p) {
+                return p;
+            }
+            p = current;
+        }
+    }
+
+    void clear(unsigned slot) {
+        mine().hazards[slot].store(nullptr, std::memory_order_release);
+    }
+
+    void clear() {
+        Record& me = mine();
+        for (std::atomic<void*>& hazard : me.hazards) {
+            hazard.store(nullptr, std::memory_order_release);
+        }
+    }
+
+    /* p must already be unreachable for threads that have not protected it */
+    template <typename T>
+    void retire(T* p) {
+        Record& me = mine();
+        me.retired.push_back(Retired{p, [](void* x) { delete static_cast<T*>(x); }});
+        std::size_t threshold = std::max<std::size_t>(
+            SCAN_THRESHOLD, 2 * SLOTS * activeRecords.load(std::memory_order_relaxed));
+        if (me.retired.size() >= threshold) {
+            scan(me);
+        }
+    }
+
+private:
+    struct Retired {
+        void* ptr;
+        void (*deleter)(void*);
+    };
+
+    // hazards are read by every scanner, retired only by the owner
+    struct Record {
+        alignas(CACHE_LINE_SIZE) std::atomic<void*> hazards[SLOTS] = {};
+        alignas(CACHE_LINE_SIZE) std::vector<Retired> retired;
+    };
+
+    Record& mine() {
+        unsigned index = ThreadIndex::getBelow(MAX_THREADS, "HazardPointers");
+        // scanners only look at records below activeRecords
+        ThreadIndex::raiseHighWater(activeRecords, index, std::memory_order_seq_cst);
+        return records[index];
+    }
+
+    void scan(Record& me) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::vector<void*> hazards;
+        unsigned numRecords = activeRecords.load(std::memory_order_seq_cst);
+        for (unsigned i = 0; i < numRecords; i++) {
+            for (const std::atomic<void*>& hazard : records[i].hazards) {
+                void* p = hazard.load(std::memory_order_seq_cst);
+                if (p) {
+                    hazards.push_back(p);
+                }
+            }
+        }
+        std::sort(hazards.begin(), hazards.end());
+
+        auto stillHazardous = std::partition(me.retired.begin(), me.retired.end(),
+            [&hazards](const Retired& r) {
+                return std::binary_search(hazards.begin(), hazards.end(), r.ptr);
+            });
+        for (auto it = stillHazardous; it != me.retired.end(); ++it) {
+            it->deleter(it->ptr);
+        }
+        me.retired.erase(stillHazardous, me.retired.end());
+    }
+
+    std::unique_ptr<Record[]> records{std::make_unique<Record[]>(MAX_THREADS)};
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> activeRecords{0};
+};
+
+#endif
@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LockBenchmark.hpp"  // runWorkload, nextRandom, parseList
+#include "ThreadIndex.hpp"
+#include "EpochReclamation.hpp"
+#include "LazyList.hpp"
+#include "LockFreeList.hpp"
+
+/* Two workloads on LinkedLists' lists:
+ *
+ *  churn     random adds and removes on the EBR LockFreeList while a sampler
+ *            thread records the most nodes ever waiting in the domain's limbo
+ *            lists (max_pending; with more threads than CPUs a thread
+ *            preempted inside its guard holds the epoch back for whole time
+ *            slices, so the peak follows the scheduler). Once the workers
+ *            have joined nothing holds the epoch back: new threads take over
+ *            their records and call collect(), and the nodes still waiting
+ *            (drained_pending) must then be 'bounded' by the three limbo
+ *            batches a live thread may hold. The set must be consistent.
+ *  traverse  contains() only, on a list half full, comparing a traversal
+ *            with EBR (plain loads, one announcement per call) against
+ *            LazyList's shared_ptr hops (a reference count update on every
+ *            node). The baseline is LazyList, not a Harris-Michael list,
+ *            because LockFreeList was that list's shared_ptr version and now
+ *            uses EBR; LazyList is the shared_ptr list left whose contains()
+ *            is the same walk (no locks, a mark check at the end), so on a
+ *            read-only run the two differ in how nodes are kept alive, not
+ *            in the algorithm. Read-only because LazyList's readers race its
+ *            writers on the shared_ptr objects.
+ *
+ * Writes CSV: workload,impl,threads,keys,ops,seconds,throughput,retired,max_pending,drained_pending,bounded,correct */
+
+constexpr int DEFAULT_KEY_RANGE = 512;
+int keyRange = DEFAULT_KEY_RANGE;
+
+/* Keys 1..keyRange: hash 0 is the head sentinel's key */
+int randomKey(std::uint32_t& rng) {
+    return 1 + nextRandom(rng) % keyRange;
+}
+
+struct StressResult {
+    WorkloadResult run;
+    std::uint64_t retired{0};
+    std::size_t maxPending{0};
+    std::size_t drainedPending{0};
+    bool bounded{true};
+};
+
+/* numThreads threads take over the records the workers left behind
+ * (ThreadIndex hands their indices out again) and each calls collect()
+ * with no thread inside a section, so every call can advance the epoch.
+ * Returns the nodes still waiting afterwards. */
+std::size_t drain(EpochReclamation& domain, int numThreads) {
+    std::barrier ready{numThreads};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; i++) {
+        threads.emplace_back([&]() {
+            ThreadIndex::get();
+            ready.arrive_and_wait();  // every record taken over before the epoch moves
+            for (int round = 0; round < 3; round++) {
+                domain.collect();
+            }
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    domain.collect();  // this thread may hold one of the workers' indices too
+    return domain.pending();
+}
+
+StressResult churn(const BenchConfig& config) {
+    EpochReclamation domain;
+    StressResult result;
+    {
+        LockFreeList<int> list{domain};
+        std::atomic<std::uint64_t> removed{0};
+        std::atomic_bool done{false};
+
+        std::thread sampler{[&]() {
+            while (!done.load(std::memory_order_relaxed)) {
+                result.maxPending = std::max(result.maxPending, domain.pending());
+                std::this_thread::sleep_for(std::chrono::microseconds{100});
+            }
+        }};
+
+        std::int64_t net;
+        result.run = runWorkload(config, [&](std::uint32_t& rng) {
+            std::uint32_t x = nextRandom(rng);
+            int key = randomKey(rng);
+            if (config.readPercent && x % 100 < config.readPercent) {
+                list.contains(key);
+                return 0;
+            }
+            if (x & (1 << 16)) {
+                return list.add(key) ? 1 : 0;
+            }
+            if (list.remove(key)) {
+                removed.fetch_add(1, std::memory_order_relaxed);
+                return -1;
+            }
+            return 0;
+        }, net);
+        done.store(true, std::memory_order_relaxed);
+        sampler.join();
+
+        std::int64_t present = 0;
+        for (int key = 1; key <= keyRange; key++) {
+            present += list.contains(key);
+        }
+        result.retired = removed.load();
+        result.run.correct = present == net && (std::int64_t) list.getSize() == net;
+        result.drainedPending = drain(domain, config.numThreads);
+        result.bounded = result.drainedPending <= config.numThreads * 3 * EpochReclamation::BATCH;
+    }
+    return result;
+}
+
+template <typename List>
+StressResult traverse(const BenchConfig& config) {
+    List list;
+    for (int key = 2; key <= keyRange; key += 2) {
+        list.add(key);
+    }
+
+    StressResult result;
+    std::atomic<std::uint64_t> wrong{0};
+    std::int64_t net;
+    result.run = runWorkload(config, [&](std::uint32_t& rng) {
+        int key = randomKey(rng);
+        bool found = list.contains(key);
+        if (found != (key % 2 == 0)) {
+            wrong.fetch_add(1, std::memory_order_relaxed);
+        }
+        return 0;
+    }, net);
+    result.run.correct = wrong.load() == 0;
+    return result;
+}
+
+struct Entry {
+    const char* workload;
+    const char* impl;
+    StressResult (*run)(const BenchConfig&);
+};
+
+const Entry ENTRIES[] = {
+    {"churn",    "LockFreeList/EBR",   churn},
+    {"traverse", "LockFreeList/EBR",   traverse<LockFreeList<int>>},
+    {"traverse", "LazyList/shared_ptr", traverse<LazyList<int>>},
+};
+
+std::string getUsageString() {
+    return std::string("USAGE:\n") +
+           "\t'./reclamation_stress [-t THREADS] [-k KEYS] [-r READ_PCT] [-d MS]'\n" +
+           "\t - THREADS is a comma-separated sweep (default 1,2,4,8,16,32)\n" +
+           "\t - KEYS is the key range, the traversed list holds half of it (default 512)\n" +
+           "\t - READ_PCT is the share of contains() in the churn workload (default 0)\n" +
+           "\t - MS is the duration of each run in milliseconds (default 200)\n" +
+           "\t'traverse' compares EBR against shared_ptr on contains() only, with LazyList\n" +
+           "\tas the shared_ptr list: its contains() is the same lock-free walk as\n" +
+           "\tLockFreeList's, whose own shared_ptr version EBR replaced\n";
+}
+
+int main(int argc, char** argv) {
+    std::vector<unsigned> threads{1, 2, 4, 8, 16, 32};
+    BenchConfig config;
+
+    if (argc % 2 == 0) {
+        std::cerr << getUsageString();
+        return -1;
+    }
+    for (int i = 1; i < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i+1];
+        if (flag == "-t") {
+            threads = parseThreadList(value);
+            if (threads.empty()) {
+                std::cerr << "THREADS must be at least 1\n" << getUsageString();
+                return -1;
+            }
+        } else if (flag == "-k") {
+            keyRange = std::stoi(value);
+        } else if (flag == "-r") {
+            config.readPercent = std::stoul(value);
+        } else if (flag == "-d") {
+            config.duration = std::chrono::milliseconds{std::stoul(value)};
+        } else {
+            std::cerr << getUsageString();
+            return -1;
+        }
+    }
+
+    bool allCorrect = true;
+    std::printf("workload,impl,threads,keys,ops,seconds,throughput,retired,max_pending,drained_pending,bounded,correct\n");
+    for (const Entry& entry : ENTRIES) {
+        for (unsigned t : threads) {
+            config.numThreads = t;
+            StressResult r = entry.run(config);
+            std::printf("%s,%s,%u,%d,%llu,%.4f,%.0f,%llu,%zu,%zu,%d,%d\n",
+                        entry.workload,
+                        entry.impl,
+                        t,
+                        keyRange,
+                        (unsigned long long) r.run.ops,
+                        r.run.seconds,
+                        r.run.ops / r.run.seconds,
+                        (unsigned long long) r.retired,
+                        r.maxPending,
+                        r.drainedPending,
+                        r.bounded ? 1 : 0,
+                        r.run.correct ? 1 : 0);
+            std::fflush(stdout);
+            if (!r.run.correct) {
+                std::cerr << entry.workload << "/" << entry.impl << ": wrong result with "
+                          << t << " threads" << std::endl;
+                allCorrect = false;
+            }
+            if (!r.bounded) {
+                std::cerr << entry.workload << "/" << entry.impl << ": retired nodes piled up with "
+                          << t << " threads" << std::endl;
+                allCorrect = false;
+            }
+        }
+    }
+
+    return allCorrect ? 0 : 1;
+}